@@ -14,6 +14,8 @@ shopt -s failglob
 find . -name "*bin" -type f -exec rm {} \; -exec printf "." \;;
 printf "\n";
 find . -name "test-files.txt" -exec rm {} \;;
+## Remove the subdirectories of "iobench generate --fanout"
+find . -mindepth 1 -type d -empty -delete;
 
 
 exit `:`;
@@ -0,0 +1,193 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * CRC32C (Castagnoli) checksums (header-only)
+ *
+ * Uses the CPU's CRC32 instruction where there is one (SSE4.2 on x86,
+ * the CRC extension on ARMv8), which processes 8 bytes per instruction,
+ * and falls back to a slicing-by-8 table implementation elsewhere. The
+ * choice is made once at runtime, so the binary does not need to be
+ * compiled for a specific CPU.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > const uint32_t crc{Checksum::CRC32C(data, length)};
+ * > std::cout << "CRC32C via " << Checksum::Implementation() << '\n';
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef CHECKSUM_H__
+#define CHECKSUM_H__
+
+
+/// System/STL
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+  #include <nmmintrin.h>
+#elif defined(__aarch64__)
+  #include <sys/auxv.h>
+  #include <asm/hwcap.h>
+#endif
+
+
+namespace Checksum {
+
+  /// Reflected CRC32C polynomial
+  constexpr uint32_t POLYNOMIAL = 0x82f63b78;
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Lookup tables for slicing-by-8 (built on first use)
+  static const uint32_t (&Tables())[8][256]
+  {
+    static uint32_t tables[8][256];
+    static const bool initialized = []() {
+      for (uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit)
+          crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1)));
+        tables[0][i] = crc;
+      }
+      for (uint32_t i = 0; i < 256; ++i)
+        for (int t = 1; t < 8; ++t)
+          tables[t][i] = (tables[t-1][i] >> 8) ^
+                         tables[0][tables[t-1][i] & 0xff];
+      return true;
+    }();
+    (void)initialized;
+    return tables;
+  }
+
+  /// Portable implementation (slicing-by-8)
+  static uint32_t CRC32CSoftware(const unsigned char* data,
+                                 size_t length,
+                                 uint32_t crc)
+  {
+    const uint32_t (&table)[8][256] = Tables();
+    for (; length >= 8; data += 8, length -= 8) {
+      uint64_t word;
+      std::memcpy(&word, data, 8);
+      word ^= crc;
+      crc = table[7][ word        & 0xff] ^ table[6][(word >>  8) & 0xff] ^
+            table[5][(word >> 16) & 0xff] ^ table[4][(word >> 24) & 0xff] ^
+            table[3][(word >> 32) & 0xff] ^ table[2][(word >> 40) & 0xff] ^
+            table[1][(word >> 48) & 0xff] ^ table[0][ word >> 56        ];
+    }
+    for (; length > 0; ++data, --length)
+      crc = (crc >> 8) ^ table[0][(crc ^ *data) & 0xff];
+    return crc;
+  }
+
+#if defined(__x86_64__)
+  /// SSE4.2 implementation
+  __attribute__((target("sse4.2")))
+  static uint32_t CRC32CHardware(const unsigned char* data,
+                                 size_t length,
+                                 uint32_t crc)
+  {
+    uint64_t crc64 = crc;
+    for (; length >= 8; data += 8, length -= 8) {
+      uint64_t word;
+      std::memcpy(&word, data, 8);
+      crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<uint32_t>(crc64);
+    for (; length > 0; ++data, --length)
+      crc = _mm_crc32_u8(crc, *data);
+    return crc;
+  }
+
+  static bool HaveHardware()
+  {
+    return __builtin_cpu_supports("sse4.2");
+  }
+#elif defined(__aarch64__)
+  /// ARMv8 CRC extension implementation
+  __attribute__((target("+crc")))
+  static uint32_t CRC32CHardware(const unsigned char* data,
+                                 size_t length,
+                                 uint32_t crc)
+  {
+    for (; length >= 8; data += 8, length -= 8) {
+      uint64_t word;
+      std::memcpy(&word, data, 8);
+      crc = __builtin_aarch64_crc32cx(crc, word);
+    }
+    for (; length > 0; ++data, --length)
+      crc = __builtin_aarch64_crc32cb(crc, *data);
+    return crc;
+  }
+
+  static bool HaveHardware()
+  {
+    return (getauxval(AT_HWCAP) & HWCAP_CRC32) != 0;
+  }
+#else
+  static uint32_t CRC32CHardware(const unsigned char* data,
+                                 size_t length,
+                                 uint32_t crc)
+  {
+    return CRC32CSoftware(data, length, crc);
+  }
+
+  static bool HaveHardware()
+  {
+    return false;
+  }
+#endif
+
+  /// Whether the CRC32 instruction is used (checked once)
+  static bool UseHardware()
+  {
+    static const bool use_hardware = HaveHardware();
+    return use_hardware;
+  }
+
+  /// Name of the implementation in use, for reports
+  static const char* Implementation()
+  {
+    if (not UseHardware())
+      return "software";
+#if defined(__x86_64__)
+    return "SSE4.2";
+#else
+    return "ARMv8 CRC";
+#endif
+  }
+
+  /**
+   * Compute the CRC32C of a buffer
+   *
+   * @param crc Result of a previous call, to continue a checksum over
+   *            several buffers
+   *
+   * @returns The CRC32C of all data so far
+   */
+  static uint32_t CRC32C(const void* data,
+                         size_t length,
+                         uint32_t crc = 0)
+  {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    crc = ~crc;
+    crc = (UseHardware() ? CRC32CHardware(bytes, length, crc)
+                         : CRC32CSoftware(bytes, length, crc));
+    return ~crc;
+  }
+
+
+}  // namespace Checksum
+
+
+#endif  // CHECKSUM_H__
+
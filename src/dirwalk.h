@@ -0,0 +1,372 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Parallel directory tree walker (header-only)
+ *
+ * Collects all regular files below a directory, like "find DIR -type f",
+ * but with several threads: directories wait on a shared stack, and
+ * every thread takes one, lists it with raw getdents64() calls into a
+ * large buffer, and pushes its subdirectories. Subdirectories are
+ * opened with openat() relative to their (still open) parent, so the
+ * kernel resolves one path component instead of the whole path. Files
+ * can be filtered by a shell glob on their name and by size; only the
+ * size filter needs a stat() call per file.
+ * Symbolic links are not followed. The order of the results is not
+ * deterministic.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > DirWalk::Filter filter;
+ * > filter.glob = "*.bin";
+ * > DirWalk::Result result;
+ * > if (not DirWalk::Walk("/data", filter, 16, result))
+ * >   return EXIT_FAILURE;
+ * > std::cout << result.files << " files\n";
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef DIRWALK_H__
+#define DIRWALK_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+namespace DirWalk {
+
+  /// Size of each thread's getdents64() buffer
+  constexpr size_t BUFFER_BYTES = 1ul << 20;
+  /// Queued directories are kept open (for openat()) up to this number;
+  /// beyond it, they are queued by path only
+  constexpr size_t MAX_OPEN_DIRECTORIES = 512;
+
+
+  /**
+   * Which files are collected
+   */
+  struct Filter {
+    /// Shell pattern for the file NAME (see fnmatch(3)); empty: all
+    std::string glob;
+    /// Size range in bytes; a negative maximum means no limit
+    long int min_size = 0;
+    long int max_size = -1;
+
+    /// Whether the filter needs to stat() every file
+    bool NeedsSize() const
+    {
+      return (min_size > 0 or max_size >= 0);
+    }
+  };
+
+
+  /**
+   * What a walk found
+   */
+  struct Result {
+    /// Paths of all collected files, NUL-terminated and back to back;
+    /// one part per thread (see FileList::List::Assign)
+    std::vector<std::string> parts;
+    size_t files = 0;
+    size_t directories = 0;
+    /// Directories and files which could not be opened or stat()ed
+    size_t errors = 0;
+  };
+
+
+  /// One record returned by getdents64()
+  struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+  };
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Walker class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class Walker {
+
+  public:
+
+    Walker(const Filter& filter,
+           size_t threads);
+
+    /// Walk the tree below "root" (see Walk())
+    bool Run(const std::string& root,
+             Result& result);
+
+  private:
+
+    /// A directory which still has to be listed
+    struct Directory {
+      std::string path;
+      /// Open file descriptor, or -1 if it has to be opened by path
+      int fd;
+    };
+
+    /// Take directories from the stack until all threads are idle
+    void Work(std::string& part,
+              Result& result);
+
+    /// List one directory, collecting files and queueing subdirectories
+    void List(const Directory& directory,
+              std::vector<char>& buffer,
+              std::string& part,
+              Result& result);
+
+    /// Queue a subdirectory of the open directory "parent_fd"
+    void Push(int parent_fd,
+              const char* name,
+              std::string&& path);
+
+    const Filter m_filter;
+    const size_t m_threads;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+    std::vector<Directory> m_stack;
+    /// Directories in "m_stack" which hold a file descriptor
+    size_t m_open_directories;
+    /// Threads which are currently listing a directory
+    size_t m_busy;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Walker class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  Walker::Walker(const Filter& filter,
+                 size_t threads)
+    : m_filter(filter),
+      m_threads(std::max<size_t>(1, threads)),
+      m_open_directories(0),
+      m_busy(0)
+  { }
+
+  /// Walk the tree below "root" (see Walk())
+  bool Walker::Run(const std::string& root,
+                   Result& result)
+  {
+    const int fd = open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    /// (the root directory "/" becomes "", so that paths are "/...")
+    std::string root_path = root;
+    while (not root_path.empty() and root_path.back() == '/')
+      root_path.pop_back();
+    m_stack.push_back(Directory{root_path, fd});
+    ++m_open_directories;
+
+    /// Every thread collects into its own part and counters
+    std::vector<std::string> parts(m_threads);
+    std::vector<Result> results(m_threads);
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < m_threads; ++t)
+      pool.emplace_back(&Walker::Work, this, std::ref(parts[t]),
+                        std::ref(results[t]));
+    for (auto& thread : pool)
+      thread.join();
+
+    result = Result();
+    for (size_t t = 0; t < m_threads; ++t) {
+      result.files       += results[t].files;
+      result.directories += results[t].directories;
+      result.errors      += results[t].errors;
+      result.parts.push_back(std::move(parts[t]));
+    }
+    return true;
+  }
+
+  /// Take directories from the stack until all threads are idle
+  void Walker::Work(std::string& part,
+                    Result& result)
+  {
+    std::vector<char> buffer(BUFFER_BYTES);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+      m_wakeup.wait(lock, [this]() {
+        return (not m_stack.empty() or m_busy == 0);
+      });
+      /// Nothing queued and nobody left who could queue more
+      if (m_stack.empty()) {
+        m_wakeup.notify_all();
+        return;
+      }
+      Directory directory = std::move(m_stack.back());
+      m_stack.pop_back();
+      if (directory.fd >= 0)
+        --m_open_directories;
+      ++m_busy;
+      lock.unlock();
+
+      List(directory, buffer, part, result);
+
+      lock.lock();
+      --m_busy;
+      if (m_busy == 0 and m_stack.empty())
+        m_wakeup.notify_all();
+    }
+  }
+
+  /// List one directory, collecting files and queueing subdirectories
+  void Walker::List(const Directory& directory,
+                    std::vector<char>& buffer,
+                    std::string& part,
+                    Result& result)
+  {
+    const int fd = (directory.fd >= 0
+                    ? directory.fd
+                    : open(directory.path.c_str(),
+                           O_RDONLY | O_DIRECTORY | O_CLOEXEC));
+    if (fd < 0) {
+      ++result.errors;
+      return;
+    }
+    ++result.directories;
+
+    for (;;) {
+      const long int length = syscall(SYS_getdents64, fd, buffer.data(),
+                                      buffer.size());
+      if (length <= 0) {
+        if (length < 0)
+          ++result.errors;
+        break;
+      }
+      for (long int position = 0; position < length; ) {
+        const LinuxDirent64* entry = reinterpret_cast<const LinuxDirent64*>(
+                                       buffer.data() + position);
+        position += entry->d_reclen;
+        const char* name = entry->d_name;
+        if (name[0] == '.' and
+            (name[1] == '\0' or (name[1] == '.' and name[2] == '\0')))
+          continue;
+
+        /// Some filesystems do not report types
+        unsigned char type = entry->d_type;
+        struct stat file_stat;
+        bool have_stat = false;
+        if (type == DT_UNKNOWN) {
+          if (fstatat(fd, name, &file_stat, AT_SYMLINK_NOFOLLOW) != 0) {
+            ++result.errors;
+            continue;
+          }
+          have_stat = true;
+          type = (S_ISDIR(file_stat.st_mode) ? DT_DIR :
+                  S_ISREG(file_stat.st_mode) ? DT_REG : DT_UNKNOWN);
+        }
+
+        if (type == DT_DIR) {
+          Push(fd, name, directory.path + '/' + name);
+          continue;
+        }
+        if (type != DT_REG)
+          continue;
+        if (not m_filter.glob.empty() and
+            fnmatch(m_filter.glob.c_str(), name, 0) != 0)
+          continue;
+        if (m_filter.NeedsSize()) {
+          if (not have_stat and
+              fstatat(fd, name, &file_stat, AT_SYMLINK_NOFOLLOW) != 0) {
+            ++result.errors;
+            continue;
+          }
+          if (file_stat.st_size < m_filter.min_size or
+              (m_filter.max_size >= 0 and
+               file_stat.st_size > m_filter.max_size))
+            continue;
+        }
+
+        part.append(directory.path);
+        part.push_back('/');
+        part.append(name);
+        part.push_back('\0');
+        ++result.files;
+      }
+    }
+    close(fd);
+  }
+
+  /// Queue a subdirectory of the open directory "parent_fd"
+  void Walker::Push(int parent_fd,
+                    const char* name,
+                    std::string&& path)
+  {
+    /// Reserve a descriptor slot under the lock, but open outside of
+    /// it, so that slow opens (cold or network filesystems) do not
+    /// serialize all threads
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const bool reserved = (m_open_directories < MAX_OPEN_DIRECTORIES);
+    if (reserved)
+      ++m_open_directories;
+    lock.unlock();
+
+    int fd = -1;
+    if (reserved)
+      fd = openat(parent_fd, name,
+                  O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+    lock.lock();
+    if (reserved and fd < 0)
+      --m_open_directories;
+    m_stack.push_back(Directory{std::move(path), fd});
+    m_wakeup.notify_one();
+  }
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Collect all regular files below a directory
+   *
+   * @param root Directory to walk; paths are reported as "root/..."
+   * @param filter Which files to collect
+   * @param threads Number of walking threads
+   * @param result Receives the paths and counts
+   *
+   * @returns FALSE IFF "root" cannot be opened (errno is set)
+   */
+  static bool Walk(const std::string& root,
+                   const Filter& filter,
+                   size_t threads,
+                   Result& result)
+  {
+    Walker walker(filter, threads);
+    return walker.Run(root, result);
+  }
+
+
+}  // namespace DirWalk
+
+
+#endif  // DIRWALK_H__
+
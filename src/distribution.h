@@ -0,0 +1,242 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Skewed discrete distributions with O(1) sampling (header-only)
+ *
+ * An AliasTable draws items 0..N-1 with arbitrary fixed weights using
+ * Vose's alias method: building takes O(N), and every draw costs one
+ * 64-bit random number, one multiplication and one table lookup, no
+ * matter how skewed the weights are. The table needs 8 bytes per item.
+ * Weight builders for common access skews are included: Zipf (item i
+ * has weight 1/(i+1)^theta), Pareto ("x% of the items get (100-x)% of
+ * the draws", with a smooth power-law falloff) and a hot set (a fixed
+ * share of the draws goes uniformly to the first items). Item 0 is
+ * always the most popular one.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > Distribution::AliasTable table;
+ * > table.Build(Distribution::Zipf(1000, 0.99));
+ * > std::mt19937_64 RNG{42};
+ * > const uint32_t item{table.Sample(RNG())};
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef DISTRIBUTION_H__
+#define DISTRIBUTION_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+
+namespace Distribution {
+
+  /// /////////////////////////////////////////////////////////////////
+  /// AliasTable class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class AliasTable {
+
+  public:
+
+    /// Constructor (empty table)
+    AliasTable();
+
+    /**
+     * Replace the table
+     *
+     * @param weights Non-negative weight per item (need not sum to 1;
+     *                at least one must be positive)
+     */
+    void Build(const std::vector<double>& weights);
+
+    /// Draw an item, given a uniformly random 64-bit number
+    uint32_t Sample(uint64_t random) const;
+
+    /// Number of items
+    size_t size() const;
+
+  private:
+
+    struct Entry {
+      /// Keep the drawn column IFF the low 32 random bits are below
+      /// this; otherwise take its alias
+      uint32_t threshold;
+      uint32_t alias;
+    };
+
+    std::vector<Entry> m_entries;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// AliasTable class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Constructor (empty table)
+  AliasTable::AliasTable()
+  { }
+
+  /**
+   * Replace the table
+   *
+   * @param weights Non-negative weight per item (need not sum to 1;
+   *                at least one must be positive)
+   */
+  void AliasTable::Build(const std::vector<double>& weights)
+  {
+    const size_t n = weights.size();
+    if (n == 0 or n > (1ull << 32))
+      throw std::length_error("AliasTable: invalid number of items");
+    double sum = 0.;
+    for (const double weight : weights)
+      sum += weight;
+    if (not (sum > 0.))
+      throw std::invalid_argument("AliasTable: all weights are zero");
+
+    /// Scale so that the average column holds exactly 1, then let every
+    /// overfull column fill up an underfull one
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < n; ++i) {
+      scaled[i] = weights[i] * n / sum;
+      (scaled[i] < 1. ? small : large).push_back(i);
+    }
+    m_entries.assign(n, Entry{0, 0});
+    while (not small.empty() and not large.empty()) {
+      const uint32_t less = small.back();
+      small.pop_back();
+      const uint32_t more = large.back();
+      m_entries[less].threshold = static_cast<uint32_t>(
+                                    std::ldexp(scaled[less], 32));
+      m_entries[less].alias = more;
+      scaled[more] -= 1. - scaled[less];
+      if (scaled[more] < 1.) {
+        large.pop_back();
+        small.push_back(more);
+      }
+    }
+    /// The rest is full up to rounding errors
+    for (const uint32_t i : large)
+      m_entries[i] = Entry{UINT32_MAX, i};
+    for (const uint32_t i : small)
+      m_entries[i] = Entry{UINT32_MAX, i};
+  }
+
+  /// Draw an item, given a uniformly random 64-bit number
+  uint32_t AliasTable::Sample(uint64_t random) const
+  {
+    /// High bits pick the column (multiply-shift instead of modulo),
+    /// low bits decide between column and alias
+    const uint32_t column = static_cast<uint32_t>(
+                              ((random >> 32) * m_entries.size()) >> 32);
+    const Entry& entry = m_entries[column];
+    return (static_cast<uint32_t>(random) < entry.threshold ? column
+                                                            : entry.alias);
+  }
+
+  /// Number of items
+  size_t AliasTable::size() const
+  {
+    return m_entries.size();
+  }
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Zipf weights: item i is drawn (i+1)^theta times less often than
+   * item 0
+   *
+   * @param theta Skew (0: uniform; ~1: typical web/cache traffic)
+   */
+  static std::vector<double> Zipf(size_t n,
+                                  double theta)
+  {
+    std::vector<double> weights(n);
+    for (size_t i = 0; i < n; ++i)
+      weights[i] = std::pow(static_cast<double>(i + 1), -theta);
+    return weights;
+  }
+
+  /**
+   * Pareto weights: the first "hot_fraction" of the items receive
+   * 1-"hot_fraction" of the draws (e.g. 0.2: the 80/20 rule). Follows
+   * the cumulative share x^b of the first x of the items, so the
+   * popularity falls off smoothly (and the head is heavy: with 0.2 and
+   * 1000 items, item 0 alone gets 38% of the draws).
+   *
+   * @param hot_fraction In (0, 0.5)
+   */
+  static std::vector<double> Pareto(size_t n,
+                                    double hot_fraction)
+  {
+    const double b = std::log(1. - hot_fraction) / std::log(hot_fraction);
+    std::vector<double> weights(n);
+    double previous = 0.;
+    for (size_t i = 0; i < n; ++i) {
+      const double next = std::pow(static_cast<double>(i + 1) / n, b);
+      weights[i] = next - previous;
+      previous = next;
+    }
+    return weights;
+  }
+
+  /**
+   * Hot-set weights: the first "hot_fraction" of the items (at least
+   * one) share "hot_probability" of the draws evenly, all others share
+   * the rest
+   */
+  static std::vector<double> HotSet(size_t n,
+                                    double hot_fraction,
+                                    double hot_probability)
+  {
+    const size_t hot = std::min(n, std::max<size_t>(1, std::llround(
+                                                 hot_fraction * n)));
+    std::vector<double> weights(n, (hot < n ? (1. - hot_probability) /
+                                              (n - hot)
+                                            : 0.));
+    std::fill(weights.begin(), weights.begin() + hot, hot_probability / hot);
+    return weights;
+  }
+
+  /**
+   * Share of all draws which go to the first "fraction" of the items
+   * (e.g. to report how much traffic a cache of that size can catch)
+   */
+  static double TopShare(const std::vector<double>& weights,
+                         double fraction)
+  {
+    const size_t top = std::min(weights.size(), static_cast<size_t>(
+                                  std::ceil(fraction * weights.size())));
+    double sum = 0.;
+    double top_sum = 0.;
+    for (size_t i = 0; i < weights.size(); ++i) {
+      sum += weights[i];
+      if (i < top)
+        top_sum += weights[i];
+    }
+    return (sum > 0. ? top_sum / sum : 0.);
+  }
+
+
+}  // namespace Distribution
+
+
+#endif  // DISTRIBUTION_H__
+
@@ -0,0 +1,253 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * On-disk file layout via FIEMAP/FIBMAP (header-only)
+ *
+ * Asks the filesystem where each file's data lies on its device: the
+ * physical position of the first extent (to sort files by disk
+ * location), and into how many physically separate fragments the file
+ * is split. Adjacent extents count as one fragment (ext4 e.g. splits
+ * contiguous data into extents of at most 128 MiB). Filesystems
+ * without FIEMAP support are asked via FIBMAP, which only yields the
+ * first block and needs CAP_SYS_RAWIO. Files are queried in parallel,
+ * in chunks of CHUNK_FILES which a pool of threads takes turns on.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > std::vector<const char*> files{"a.bin", "b.bin"};
+ * > Extents::Summary summary;
+ * > const std::vector<Extents::Layout> layouts{
+ * >   Extents::Query(files, 8, summary)};
+ * > std::cout << summary.fragmented_files << " fragmented files\n";
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef EXTENTS_H__
+#define EXTENTS_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace Extents {
+
+  /// Number of files a thread takes from the list at once
+  constexpr size_t CHUNK_FILES = 64;
+  /// Extents fetched per FIEMAP call
+  constexpr size_t BATCH_EXTENTS = 256;
+
+
+  /**
+   * Where one file lies on disk
+   */
+  struct Layout {
+    uint64_t device;
+    /// Byte position of the first extent on the device
+    uint64_t physical;
+    /// Physically separate parts (0 if unknown, e.g. from FIBMAP)
+    uint32_t fragments;
+    /// FALSE if the position is unknown (no data, inline data, delayed
+    /// allocation, or no FIEMAP/FIBMAP support)
+    bool located;
+  };
+
+
+  /**
+   * Fragmentation of a set of files
+   */
+  struct Summary {
+    size_t files;
+    /// Files whose position is known
+    size_t located_files;
+    /// ... of which only FIBMAP could locate (no fragment counts)
+    size_t fibmap_files;
+    /// Files with more than one fragment, and all fragments (of the
+    /// files which FIEMAP located)
+    size_t fragmented_files;
+    size_t fragments;
+    size_t max_fragments;
+    /// Files which could not be opened
+    size_t failed_files;
+  };
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Locate one open file with FIEMAP
+   *
+   * @param buffer Scratch space for the extent list (reused)
+   *
+   * @returns FALSE IFF FIEMAP is not supported
+   */
+  static bool QueryFiemap(int fd,
+                          std::vector<uint64_t>& buffer,
+                          Layout& layout)
+  {
+    const size_t bytes = sizeof(struct fiemap) +
+                         BATCH_EXTENTS * sizeof(struct fiemap_extent);
+    buffer.resize((bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+    struct fiemap* map = reinterpret_cast<struct fiemap*>(buffer.data());
+
+    uint64_t start = 0;
+    uint64_t next_physical = 0;
+    for (;;) {
+      std::fill(buffer.begin(), buffer.end(), 0);
+      map->fm_start = start;
+      map->fm_length = FIEMAP_MAX_OFFSET - start;
+      map->fm_extent_count = BATCH_EXTENTS;
+      if (ioctl(fd, FS_IOC_FIEMAP, map) != 0)
+        return false;
+      if (map->fm_mapped_extents == 0)
+        return true;
+
+      for (uint32_t e = 0; e < map->fm_mapped_extents; ++e) {
+        const struct fiemap_extent& extent = map->fm_extents[e];
+        if (start == 0 and e == 0) {
+          layout.located = not (extent.fe_flags &
+                                (FIEMAP_EXTENT_UNKNOWN |
+                                 FIEMAP_EXTENT_DATA_INLINE));
+          layout.physical = extent.fe_physical;
+        }
+        if (layout.fragments == 0 or extent.fe_physical != next_physical)
+          ++layout.fragments;
+        next_physical = extent.fe_physical + extent.fe_length;
+        if (extent.fe_flags & FIEMAP_EXTENT_LAST)
+          return true;
+      }
+      const struct fiemap_extent& last =
+        map->fm_extents[map->fm_mapped_extents - 1];
+      start = last.fe_logical + last.fe_length;
+    }
+  }
+
+  /**
+   * Locate one open file with FIBMAP (first block only)
+   *
+   * @returns FALSE IFF FIBMAP is not supported or not permitted
+   */
+  static bool QueryFibmap(int fd,
+                          Layout& layout)
+  {
+    int block_size = 0;
+    int block = 0;
+    if (ioctl(fd, FIGETBSZ, &block_size) != 0 or
+        ioctl(fd, FIBMAP, &block) != 0)
+      return false;
+    if (block > 0) {
+      layout.physical = static_cast<uint64_t>(block) * block_size;
+      layout.located = true;
+    }
+    return true;
+  }
+
+  /**
+   * Locate a list of files and summarize their fragmentation
+   *
+   * @param files Any list with size() and operator[] which yields
+   *              const char*
+   * @param threads Number of threads to query with
+   * @param summary Receives the fragmentation summary
+   *
+   * @returns One Layout per file, in list order
+   */
+  template <typename Files>
+  static std::vector<Layout> Query(const Files& files,
+                                   size_t threads,
+                                   Summary& summary)
+  {
+    std::vector<Layout> layouts(files.size(), Layout{0, 0, 0, false});
+    threads = std::max<size_t>(1, std::min(threads,
+                                           (files.size() + CHUNK_FILES - 1) /
+                                           CHUNK_FILES));
+    std::atomic<size_t> next_chunk{0};
+    std::vector<Summary> results(threads, Summary{0, 0, 0, 0, 0, 0, 0});
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+      pool.emplace_back([&, t]() {
+        std::vector<uint64_t> buffer;
+        Summary& result = results[t];
+        for (;;) {
+          const size_t begin = next_chunk.fetch_add(CHUNK_FILES);
+          if (begin >= files.size())
+            return;
+          const size_t end = std::min(begin + CHUNK_FILES, files.size());
+          for (size_t i = begin; i < end; ++i) {
+            Layout& layout = layouts[i];
+            ++result.files;
+            const int fd = open(files[i], O_RDONLY | O_CLOEXEC);
+            struct stat file_stat;
+            if (fd < 0 or fstat(fd, &file_stat) != 0) {
+              ++result.failed_files;
+              if (fd >= 0)
+                close(fd);
+              continue;
+            }
+            layout.device = file_stat.st_dev;
+            const bool fiemap = QueryFiemap(fd, buffer, layout);
+            if (not fiemap) {
+              layout = Layout{static_cast<uint64_t>(file_stat.st_dev),
+                              0, 0, false};
+              if (QueryFibmap(fd, layout) and layout.located)
+                ++result.fibmap_files;
+            }
+            close(fd);
+
+            if (not layout.located)
+              continue;
+            ++result.located_files;
+            /// Fragments are only known for files FIEMAP located
+            if (not fiemap)
+              continue;
+            if (layout.fragments > 1)
+              ++result.fragmented_files;
+            result.fragments += layout.fragments;
+            result.max_fragments = std::max<size_t>(result.max_fragments,
+                                                    layout.fragments);
+          }
+        }
+      });
+    }
+    for (auto& thread : pool)
+      thread.join();
+
+    summary = Summary{0, 0, 0, 0, 0, 0, 0};
+    for (const auto& result : results) {
+      summary.files            += result.files;
+      summary.located_files    += result.located_files;
+      summary.fibmap_files     += result.fibmap_files;
+      summary.fragmented_files += result.fragmented_files;
+      summary.fragments        += result.fragments;
+      summary.max_fragments     = std::max(summary.max_fragments,
+                                           result.max_fragments);
+      summary.failed_files     += result.failed_files;
+    }
+    return layouts;
+  }
+
+
+}  // namespace Extents
+
+
+#endif  // EXTENTS_H__
+
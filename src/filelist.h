@@ -0,0 +1,351 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Compact list of file paths, loaded from a one-path-per-line text
+ * file (header-only)
+ *
+ * All paths live in ONE arena of NUL-terminated strings, plus one
+ * 64-bit offset per path; there is no per-path heap allocation. The
+ * list file is mapped and parsed by several threads at once: every
+ * thread takes a slice (cut at line breaks), counts its paths and
+ * bytes, and then copies its paths to their final place in the arena.
+ * Lines are taken verbatim (so paths may contain spaces), except for a
+ * trailing '\r'; empty lines are skipped. Lists which were collected
+ * elsewhere (e.g. by DirWalk) can be adopted with Assign().
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > FileList::List files;
+ * > if (not files.Load("test-files.txt", 8))
+ * >   return EXIT_FAILURE;
+ * > for (size_t i = 0; i < files.size(); ++i)
+ * >   std::cout << files[i] << '\n';
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef FILELIST_H__
+#define FILELIST_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace FileList {
+
+  /// Lists smaller than this are parsed by a single thread
+  constexpr size_t MIN_SLICE_BYTES = 1ul << 20;
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// List class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class List {
+
+  public:
+
+    /// Constructor (empty list)
+    List();
+
+    /**
+     * Replace the list by the contents of a file
+     *
+     * @param filename One path per line
+     * @param threads Maximum number of parsing threads
+     *
+     * @returns FALSE IFF the file cannot be read (errno is set)
+     */
+    bool Load(const std::string& filename, size_t threads);
+
+    /**
+     * Replace the list by paths which were collected elsewhere; every
+     * part is indexed and copied by its own thread
+     *
+     * @param parts NUL-terminated paths, back to back
+     */
+    void Assign(const std::vector<std::string>& parts);
+
+    /// The "index"th path (valid while the list lives)
+    const char* operator[](size_t index) const;
+
+    /// Number of paths
+    size_t size() const;
+
+    bool empty() const;
+
+    /// Memory used by arena and index, in bytes
+    size_t MemoryBytes() const;
+
+  private:
+
+    /// One thread's part of the list file
+    struct Slice {
+      const char* begin;
+      const char* end;
+      /// Number of paths, and arena bytes they need
+      size_t paths;
+      size_t bytes;
+    };
+
+    /// Count the paths in a slice (first pass)
+    static void Count(Slice& slice);
+
+    /// Copy a slice's paths into the arena (second pass)
+    static void Copy(const Slice& slice,
+                     char* arena,
+                     size_t arena_position,
+                     uint64_t* offsets);
+
+    /// Index and copy one part of Assign() (like Copy())
+    static void CopyPart(const std::string& part,
+                         char* arena,
+                         size_t arena_position,
+                         uint64_t* offsets);
+
+    /// Call "function(line, length)" for every non-empty line
+    template <typename Function>
+    static void ForEachLine(const char* begin,
+                            const char* end,
+                            Function function);
+
+    std::unique_ptr<char[]> m_arena;
+    size_t m_arena_size;
+    std::unique_ptr<uint64_t[]> m_offsets;
+    size_t m_size;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// List class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Constructor (empty list)
+  List::List()
+    : m_arena_size(0),
+      m_size(0)
+  { }
+
+  /**
+   * Replace the list by the contents of a file
+   *
+   * @param filename One path per line
+   * @param threads Maximum number of parsing threads
+   *
+   * @returns FALSE IFF the file cannot be read (errno is set)
+   */
+  bool List::Load(const std::string& filename, size_t threads)
+  {
+    const int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      return false;
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+      close(fd);
+      return false;
+    }
+    const size_t length = file_stat.st_size;
+    const char* data = nullptr;
+    if (length > 0) {
+      void* map = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED) {
+        close(fd);
+        return false;
+      }
+      madvise(map, length, MADV_SEQUENTIAL);
+      data = static_cast<const char*>(map);
+    }
+    close(fd);
+
+    /// Cut the file into slices which end at line breaks
+    threads = std::max<size_t>(1, std::min(threads,
+                                           length / MIN_SLICE_BYTES));
+    std::vector<Slice> slices;
+    const char* position = data;
+    for (size_t t = 0; t < threads and position < data + length; ++t) {
+      const char* end = data + length * (t + 1) / threads;
+      if (end < position)
+        end = position;
+      if (end < data + length) {
+        const void* newline = std::memchr(end, '\n', data + length - end);
+        end = (newline ? static_cast<const char*>(newline) + 1
+                       : data + length);
+      }
+      slices.push_back(Slice{position, end, 0, 0});
+      position = end;
+    }
+
+    /// First pass: count
+    std::vector<std::thread> pool;
+    for (auto& slice : slices)
+      pool.emplace_back(Count, std::ref(slice));
+    for (auto& thread : pool)
+      thread.join();
+    pool.clear();
+
+    size_t paths = 0;
+    size_t bytes = 0;
+    for (const auto& slice : slices) {
+      paths += slice.paths;
+      bytes += slice.bytes;
+    }
+    /// No zero-initialization (the arena may be gigabytes)
+    m_arena.reset(new char[std::max<size_t>(bytes, 1)]);
+    m_arena_size = bytes;
+    m_offsets.reset(new uint64_t[std::max<size_t>(paths, 1)]);
+    m_size = paths;
+
+    /// Second pass: copy
+    size_t first_path = 0;
+    size_t arena_position = 0;
+    for (const auto& slice : slices) {
+      pool.emplace_back(Copy, std::cref(slice), m_arena.get(),
+                        arena_position, m_offsets.get() + first_path);
+      first_path += slice.paths;
+      arena_position += slice.bytes;
+    }
+    for (auto& thread : pool)
+      thread.join();
+
+    if (data)
+      munmap(const_cast<char*>(data), length);
+    return true;
+  }
+
+  /**
+   * Replace the list by paths which were collected elsewhere; every
+   * part is indexed and copied by its own thread
+   *
+   * @param parts NUL-terminated paths, back to back
+   */
+  void List::Assign(const std::vector<std::string>& parts)
+  {
+    size_t paths = 0;
+    size_t bytes = 0;
+    std::vector<size_t> part_paths;
+    for (const auto& part : parts) {
+      part_paths.push_back(std::count(part.begin(), part.end(), '\0'));
+      paths += part_paths.back();
+      bytes += part.size();
+    }
+    m_arena.reset(new char[std::max<size_t>(bytes, 1)]);
+    m_arena_size = bytes;
+    m_offsets.reset(new uint64_t[std::max<size_t>(paths, 1)]);
+    m_size = paths;
+
+    std::vector<std::thread> pool;
+    size_t first_path = 0;
+    size_t arena_position = 0;
+    for (size_t p = 0; p < parts.size(); ++p) {
+      pool.emplace_back(CopyPart, std::cref(parts[p]), m_arena.get(),
+                        arena_position, m_offsets.get() + first_path);
+      first_path += part_paths[p];
+      arena_position += parts[p].size();
+    }
+    for (auto& thread : pool)
+      thread.join();
+  }
+
+  /// The "index"th path (valid while the list lives)
+  const char* List::operator[](size_t index) const
+  {
+    return m_arena.get() + m_offsets[index];
+  }
+
+  /// Number of paths
+  size_t List::size() const
+  {
+    return m_size;
+  }
+
+  bool List::empty() const
+  {
+    return (m_size == 0);
+  }
+
+  /// Memory used by arena and index, in bytes
+  size_t List::MemoryBytes() const
+  {
+    return m_arena_size + m_size * sizeof(uint64_t);
+  }
+
+  /// Count the paths in a slice (first pass)
+  void List::Count(Slice& slice)
+  {
+    ForEachLine(slice.begin, slice.end,
+                [&slice](const char*, size_t line_length) {
+                  ++slice.paths;
+                  slice.bytes += line_length + 1;
+                });
+  }
+
+  /// Copy a slice's paths into the arena (second pass)
+  void List::Copy(const Slice& slice,
+                  char* arena,
+                  size_t arena_position,
+                  uint64_t* offsets)
+  {
+    ForEachLine(slice.begin, slice.end,
+                [&](const char* line, size_t line_length) {
+                  *offsets++ = arena_position;
+                  std::memcpy(arena + arena_position, line, line_length);
+                  arena[arena_position + line_length] = '\0';
+                  arena_position += line_length + 1;
+                });
+  }
+
+  /// Index and copy one part of Assign() (like Copy())
+  void List::CopyPart(const std::string& part,
+                      char* arena,
+                      size_t arena_position,
+                      uint64_t* offsets)
+  {
+    std::memcpy(arena + arena_position, part.data(), part.size());
+    for (size_t position = 0; position < part.size(); ) {
+      *offsets++ = arena_position + position;
+      position += std::strlen(part.data() + position) + 1;
+    }
+  }
+
+  /// Call "function(line, length)" for every non-empty line
+  template <typename Function>
+  void List::ForEachLine(const char* begin,
+                         const char* end,
+                         Function function)
+  {
+    while (begin < end) {
+      const void* newline = std::memchr(begin, '\n', end - begin);
+      const char* line_end = (newline ? static_cast<const char*>(newline)
+                                      : end);
+      size_t line_length = line_end - begin;
+      if (line_length > 0 and begin[line_length - 1] == '\r')
+        --line_length;
+      if (line_length > 0)
+        function(begin, line_length);
+      begin = line_end + 1;
+    }
+  }
+
+
+}  // namespace FileList
+
+
+#endif  // FILELIST_H__
+
@@ -0,0 +1,414 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Parallel test dataset generator (header-only)
+ *
+ * Writes files of given sizes full of random data, using many threads,
+ * large aligned writes into preallocated (fallocate) files, and a
+ * 4-lane xoshiro256+ generator which the compiler can vectorize. Files
+ * are spread over a tree of directories with at most "fanout" entries
+ * each.
+ *
+ * With "verify", every VERIFY_BLOCK bytes of a file start with a
+ * BlockHeader (file id, offset, seed, CRC32C of the rest of the block),
+ * so that readers can detect corrupted or misplaced data with
+ * CheckBlock().
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > Generator::Config config;
+ * > config.directory = "example-data";
+ * > config.sizes     = std::vector<size_t>(100, 10*1024*1024);
+ * > std::vector<std::string> filenames;
+ * > std::atomic<size_t> written{0};
+ * > if (not Generator::Generate(config, filenames, written))
+ * >   return EXIT_FAILURE;
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef GENERATOR_H__
+#define GENERATOR_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/// Local files
+#include "checksum.h"
+
+
+namespace Generator {
+
+  /**
+   * What to generate
+   */
+  struct Config {
+    /// Root directory (is created if necessary)
+    std::string directory{"."};
+    /// One entry per file
+    std::vector<size_t> sizes;
+    /// Maximum number of entries per directory (0 = all files in one
+    /// directory)
+    size_t fanout{0};
+    /// Number of writing threads
+    size_t threads{1};
+    /// Size of each write request
+    size_t write_size{4*1024*1024};
+    /// Write with O_DIRECT
+    bool direct{false};
+    /// Stamp every block with a BlockHeader (needs "write_size" to be a
+    /// multiple of VERIFY_BLOCK)
+    bool verify{false};
+    uint64_t seed{0};
+  };
+
+  /// Buffer (and O_DIRECT) alignment
+  constexpr size_t ALIGNMENT = 4096;
+  /// Size of the blocks which carry a BlockHeader (only the last block
+  /// of a file may be shorter)
+  constexpr size_t VERIFY_BLOCK = 4096;
+  constexpr uint32_t VERIFY_MAGIC = 0x69626b31;  // "ibk1"
+
+  /**
+   * Start of every block of a "verify" dataset. The checksum covers
+   * everything after itself up to the end of the block.
+   */
+  struct BlockHeader {
+    uint32_t magic;
+    uint32_t crc;
+    uint64_t file_id;
+    /// Position of the block in its file
+    uint64_t offset;
+    uint64_t seed;
+  };
+  static_assert(sizeof(BlockHeader) == 32, "BlockHeader must be packed");
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Xoshiro class declaration
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Four independent xoshiro256+ streams, interleaved so that one
+   * Fill() step updates all four at once (SIMD-friendly). Only meant
+   * for filling buffers with noise, not for statistics.
+   */
+  class Xoshiro {
+
+  public:
+
+    /// Constructor (seeds all lanes via SplitMix64)
+    Xoshiro(uint64_t seed);
+
+    /// Fill "words" 64-bit words with random data
+    void Fill(uint64_t* data, size_t words);
+
+  private:
+
+    static uint64_t Rotate(uint64_t x, int k);
+
+    static constexpr size_t LANES = 4;
+    uint64_t m_s0[LANES];
+    uint64_t m_s1[LANES];
+    uint64_t m_s2[LANES];
+    uint64_t m_s3[LANES];
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Xoshiro class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Constructor (seeds all lanes via SplitMix64)
+  Xoshiro::Xoshiro(uint64_t seed)
+  {
+    auto SplitMix64 = [&seed]() -> uint64_t {
+      uint64_t z = (seed += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+    };
+    for (size_t lane = 0; lane < LANES; ++lane) {
+      m_s0[lane] = SplitMix64();
+      m_s1[lane] = SplitMix64();
+      m_s2[lane] = SplitMix64();
+      m_s3[lane] = SplitMix64();
+    }
+  }
+
+  /// Fill "words" 64-bit words with random data
+  void Xoshiro::Fill(uint64_t* data, size_t words)
+  {
+    size_t i = 0;
+    for (; i + LANES <= words; i += LANES) {
+      for (size_t lane = 0; lane < LANES; ++lane) {
+        data[i + lane] = m_s0[lane] + m_s3[lane];
+        const uint64_t t = m_s1[lane] << 17;
+        m_s2[lane] ^= m_s0[lane];
+        m_s3[lane] ^= m_s1[lane];
+        m_s1[lane] ^= m_s2[lane];
+        m_s0[lane] ^= m_s3[lane];
+        m_s2[lane] ^= t;
+        m_s3[lane] = Rotate(m_s3[lane], 45);
+      }
+    }
+    for (size_t lane = 0; i < words; ++i, ++lane)
+      data[i] = m_s0[lane] + m_s3[lane];
+  }
+
+  uint64_t Xoshiro::Rotate(uint64_t x, int k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Relative path of a file: the digits of "index" in base "fanout"
+   * (all but the last) name the directories it lives in
+   *
+   * @param levels Number of directory levels
+   */
+  static std::string RelativePath(size_t index,
+                                  size_t fanout,
+                                  size_t levels)
+  {
+    std::string path;
+    size_t divisor = 1;
+    for (size_t level = 0; level < levels; ++level)
+      divisor *= fanout;
+    for (size_t level = 0; level < levels; ++level) {
+      path += "d" + std::to_string(index / divisor % fanout) + "/";
+      divisor /= fanout;
+    }
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020zu.bin", index);
+    return path + name;
+  }
+
+  /// Number of directory levels needed for "files" files
+  static size_t DirectoryLevels(size_t files, size_t fanout)
+  {
+    size_t levels = 0;
+    for (size_t capacity = fanout; fanout > 1 and capacity < files;
+         capacity *= fanout)
+      ++levels;
+    return levels;
+  }
+
+  /**
+   * Write a BlockHeader into a block (whose payload is already filled).
+   * Blocks shorter than a header (file tails) are left as they are.
+   *
+   * @param length Block length (at most VERIFY_BLOCK)
+   */
+  static void StampBlock(char* block,
+                         size_t length,
+                         uint64_t file_id,
+                         uint64_t offset,
+                         uint64_t seed)
+  {
+    if (length < sizeof(BlockHeader))
+      return;
+    BlockHeader header{VERIFY_MAGIC, 0, file_id, offset, seed};
+    std::memcpy(block, &header, sizeof(header));
+    header.crc = Checksum::CRC32C(block + 8, length - 8);
+    std::memcpy(block, &header, sizeof(header));
+  }
+
+  /**
+   * Check one block of a "verify" dataset
+   *
+   * @param length Block length (at most VERIFY_BLOCK)
+   * @param offset Where the block was read from
+   * @param header Receives the block's header (for reports)
+   *
+   * @returns NULL IFF the block is intact, else the reason why not
+   */
+  static const char* CheckBlock(const char* block,
+                                size_t length,
+                                uint64_t offset,
+                                BlockHeader& header)
+  {
+    if (length < sizeof(BlockHeader))
+      return nullptr;
+    std::memcpy(&header, block, sizeof(header));
+    if (header.magic != VERIFY_MAGIC)
+      return "no block header";
+    if (header.crc != Checksum::CRC32C(block + 8, length - 8))
+      return "checksum mismatch";
+    if (header.offset != offset)
+      return "block from wrong offset";
+    return nullptr;
+  }
+
+  /// Create a directory and all its parents ("mkdir -p")
+  static bool MakeDirectories(const std::string& path)
+  {
+    for (size_t slash = path.find('/', 1); ;
+         slash = path.find('/', slash + 1)) {
+      const std::string prefix = path.substr(0, slash);
+      if (mkdir(prefix.c_str(), 0755) != 0 and errno != EEXIST)
+        return false;
+      if (slash == std::string::npos)
+        return true;
+    }
+  }
+
+  /**
+   * Write one file
+   *
+   * @param file_id Stored in the BlockHeaders (with "verify")
+   * @param buffer ALIGNMENT-aligned scratch buffer of "write_size" bytes
+   * @param written Increased by every written chunk (for progress)
+   *
+   * @returns FALSE IFF the file could not be written
+   */
+  static bool WriteFile(const std::string& filename,
+                        uint64_t file_id,
+                        size_t size,
+                        const Config& config,
+                        Xoshiro& random,
+                        char* buffer,
+                        std::atomic<size_t>& written)
+  {
+    const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC |
+                      (config.direct ? O_DIRECT : 0);
+    const int fd = open(filename.c_str(), flags, 0644);
+    if (fd < 0) {
+      std::cerr << "Cannot write " << filename << " ("
+                << std::strerror(errno) << ")" << std::endl;
+      return false;
+    }
+    /// Reserve all blocks at once. Not every filesystem supports this,
+    /// so failure is fine (posix_fallocate() would instead emulate it by
+    /// writing zeros, i.e. writing everything twice).
+    if (size > 0)
+      fallocate(fd, 0, 0, size);
+
+    bool ok = true;
+    for (size_t position = 0; ok and position < size; ) {
+      const size_t length = std::min(config.write_size, size - position);
+      /// O_DIRECT needs the tail padded; it is truncated afterwards
+      const size_t padded = (config.direct
+                             ? (length + ALIGNMENT - 1) / ALIGNMENT *
+                               ALIGNMENT
+                             : length);
+      random.Fill(reinterpret_cast<uint64_t*>(buffer),
+                  (padded + 7) / 8);
+      if (config.verify) {
+        for (size_t block = 0; block < length; block += VERIFY_BLOCK)
+          StampBlock(buffer + block, std::min(VERIFY_BLOCK, length - block),
+                     file_id, position + block, config.seed);
+      }
+      const ssize_t result = pwrite(fd, buffer, padded, position);
+      if (result < static_cast<ssize_t>(length)) {
+        std::cerr << "Cannot write " << filename << " ("
+                  << (result < 0 ? std::strerror(errno) : "short write")
+                  << ")" << std::endl;
+        ok = false;
+        break;
+      }
+      position += length;
+      written.fetch_add(length, std::memory_order_relaxed);
+    }
+    if (ok and config.direct and ftruncate(fd, size) != 0)
+      ok = false;
+    close(fd);
+    return ok;
+  }
+
+  /**
+   * Generate all files of a Config in parallel
+   *
+   * @param filenames Receives the paths of all files (prefixed with
+   *                  the root directory)
+   * @param written Increased while writing, for progress reports from
+   *                other threads
+   *
+   * @returns FALSE IFF any file could not be written
+   */
+  static bool Generate(const Config& config,
+                       std::vector<std::string>& filenames,
+                       std::atomic<size_t>& written)
+  {
+    const size_t levels = DirectoryLevels(config.sizes.size(),
+                                          config.fanout);
+    filenames.clear();
+    for (size_t i = 0; i < config.sizes.size(); ++i) {
+      filenames.push_back(config.directory + "/" +
+                          RelativePath(i, config.fanout, levels));
+      const std::string directory =
+          filenames.back().substr(0, filenames.back().rfind('/'));
+      /// Consecutive files mostly share their directory
+      if (i == 0 or directory != filenames[i-1].substr(
+                                     0, filenames[i-1].rfind('/'))) {
+        if (not MakeDirectories(directory)) {
+          std::cerr << "Cannot create directory " << directory << " ("
+                    << std::strerror(errno) << ")" << std::endl;
+          return false;
+        }
+      }
+    }
+
+    const size_t buffer_size = (config.write_size + ALIGNMENT - 1) /
+                               ALIGNMENT * ALIGNMENT;
+    std::atomic<size_t> next_file{0};
+    std::atomic<bool> ok{true};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < std::max<size_t>(1, config.threads); ++t) {
+      threads.emplace_back([&, t]() {
+        Xoshiro random(config.seed + t);
+        char* buffer = static_cast<char*>(std::aligned_alloc(ALIGNMENT,
+                                                             buffer_size));
+        if (not buffer) {
+          ok = false;
+          return;
+        }
+        for (;;) {
+          const size_t i = next_file.fetch_add(1);
+          if (i >= config.sizes.size())
+            break;
+          if (not WriteFile(filenames[i], i, config.sizes[i], config,
+                            random, buffer, written))
+            ok = false;
+        }
+        std::free(buffer);
+      });
+    }
+    for (auto& thread : threads)
+      thread.join();
+    return ok;
+  }
+
+
+}  // namespace Generator
+
+
+#endif  // GENERATOR_H__
+
@@ -0,0 +1,247 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Log-linear latency histogram in the style of HdrHistogram
+ * (header-only)
+ *
+ * Values below 2^SUB_BUCKET_BITS are counted exactly. Above that, every
+ * power-of-two range [2^e, 2^(e+1)) is split into 2^SUB_BUCKET_BITS
+ * equally wide buckets, so the relative error of any reported value is
+ * below 2^-SUB_BUCKET_BITS (~3%), from nanoseconds up to centuries.
+ *
+ * Every histogram has exactly ONE writing thread. Counters are relaxed
+ * atomics, so other threads may merge/read a histogram at any time
+ * without locks (and without slowing down the writer).
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > LatencyHistogram::Histogram histogram;
+ * >
+ * > /// In the worker thread
+ * > histogram.Record(elapsed_nanoseconds);
+ * >
+ * > /// In the reporting thread
+ * > LatencyHistogram::Histogram total;
+ * > total.Add(histogram);
+ * > std::cout << "p99=" << total.Percentile(99.) << "ns\n";
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef LATENCYHISTOGRAM_H__
+#define LATENCYHISTOGRAM_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+
+namespace LatencyHistogram {
+
+  /// Each power-of-two range is split into 2^SUB_BUCKET_BITS buckets
+  constexpr unsigned SUB_BUCKET_BITS = 5;
+  constexpr uint64_t SUB_BUCKETS = (1ull << SUB_BUCKET_BITS);
+  /// Enough buckets for every uint64_t value
+  constexpr size_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Bucket index of a value
+  static size_t BucketOf(uint64_t value)
+  {
+    if (value < SUB_BUCKETS)
+      return value;
+    const unsigned exponent = 63 - __builtin_clzll(value);
+    const unsigned shift = exponent - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKETS + ((value >> shift) - SUB_BUCKETS);
+  }
+
+  /// Largest value which falls into a bucket
+  static uint64_t HighestValueIn(size_t bucket)
+  {
+    if (bucket < SUB_BUCKETS)
+      return bucket;
+    const unsigned shift = bucket / SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = bucket % SUB_BUCKETS + SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+  }
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Histogram class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class Histogram {
+
+  public:
+
+    /// Constructor
+    Histogram();
+
+    /// Record one value (ONLY from the owning thread)
+    void Record(uint64_t value);
+
+    /// Add all values of another histogram (from any thread)
+    void Add(const Histogram& other);
+
+    /// Number of recorded values
+    uint64_t Count() const;
+
+    /// Mean of all recorded values (0 if empty)
+    double Mean() const;
+
+    /// Largest recorded value (exact)
+    uint64_t Max() const;
+
+    /**
+     * Estimate a percentile
+     *
+     * @param percentile In [0, 100]
+     *
+     * @returns The largest value of the bucket which contains the
+     *          requested percentile (0 if empty)
+     */
+    uint64_t Percentile(double percentile) const;
+
+    /// Remove all values (ONLY from the owning thread)
+    void Reset();
+
+  private:
+
+    /// Relaxed single-writer increment
+    static void Increment(std::atomic<uint64_t>& counter, uint64_t amount);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_max;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Histogram class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Constructor
+  Histogram::Histogram()
+    : m_counts(new std::atomic<uint64_t>[BUCKETS])
+  {
+    Reset();
+  }
+
+  /// Record one value (ONLY from the owning thread)
+  void Histogram::Record(uint64_t value)
+  {
+    Increment(m_counts[BucketOf(value)], 1);
+    Increment(m_count, 1);
+    Increment(m_sum, value);
+    if (value > m_max.load(std::memory_order_relaxed))
+      m_max.store(value, std::memory_order_relaxed);
+  }
+
+  /// Add all values of another histogram (from any thread)
+  void Histogram::Add(const Histogram& other)
+  {
+    for (size_t i = 0; i < BUCKETS; ++i) {
+      const uint64_t count = other.m_counts[i].load(std::memory_order_relaxed);
+      if (count > 0)
+        m_counts[i].fetch_add(count, std::memory_order_relaxed);
+    }
+    m_count.fetch_add(other.m_count.load(std::memory_order_relaxed),
+                      std::memory_order_relaxed);
+    m_sum.fetch_add(other.m_sum.load(std::memory_order_relaxed),
+                    std::memory_order_relaxed);
+    const uint64_t other_max = other.m_max.load(std::memory_order_relaxed);
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (other_max > max and
+           not m_max.compare_exchange_weak(max, other_max,
+                                           std::memory_order_relaxed))
+      ;
+  }
+
+  /// Number of recorded values
+  uint64_t Histogram::Count() const
+  {
+    return m_count.load(std::memory_order_relaxed);
+  }
+
+  /// Mean of all recorded values (0 if empty)
+  double Histogram::Mean() const
+  {
+    const uint64_t count = Count();
+    if (count == 0)
+      return 0.;
+    return static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count;
+  }
+
+  /// Largest recorded value (exact)
+  uint64_t Histogram::Max() const
+  {
+    return m_max.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Estimate a percentile
+   *
+   * @param percentile In [0, 100]
+   *
+   * @returns The largest value of the bucket which contains the
+   *          requested percentile (0 if empty)
+   */
+  uint64_t Histogram::Percentile(double percentile) const
+  {
+    /// Sum up the buckets first; the total counter may run ahead of
+    /// them while the writer is active
+    uint64_t total = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+      total += m_counts[i].load(std::memory_order_relaxed);
+    if (total == 0)
+      return 0;
+
+    uint64_t rank = static_cast<uint64_t>(percentile / 100. * total + 0.5);
+    if (rank < 1)
+      rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+      seen += m_counts[i].load(std::memory_order_relaxed);
+      if (seen >= rank)
+        return std::min(HighestValueIn(i), Max());
+    }
+    return Max();
+  }
+
+  /// Remove all values (ONLY from the owning thread)
+  void Histogram::Reset()
+  {
+    for (size_t i = 0; i < BUCKETS; ++i)
+      m_counts[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+  }
+
+  /// Relaxed single-writer increment (no locked read-modify-write)
+  void Histogram::Increment(std::atomic<uint64_t>& counter, uint64_t amount)
+  {
+    counter.store(counter.load(std::memory_order_relaxed) + amount,
+                  std::memory_order_relaxed);
+  }
+
+
+}  // namespace LatencyHistogram
+
+
+#endif  // LATENCYHISTOGRAM_H__
+
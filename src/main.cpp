@@ -9,9 +9,13 @@
 #include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
+#include <set>
 #include <sstream>
 #include <string>
 #include <thread>
@@ -22,12 +26,37 @@
 #include <sys/times.h>
 #include <sys/vtimes.h>
 
+/// For raw file I/O
+#include <cerrno>
+#include <cstdint>
+#include <climits>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+/// Linux >= 5.14
+#ifndef MADV_POPULATE_READ
+  #define MADV_POPULATE_READ 22
+#endif
+
 /// Local files
-#include "fps.h"
+#include "dirwalk.h"
+#include "distribution.h"
+#include "extents.h"
+#include "filelist.h"
+#include "histogram.h"
+#include "generator.h"
 #include "OptionParser.h"
 #include "pacemaker.h"
+#include "pagecache.h"
 #include "TextDecorator.h"
+#include "throughput.h"
 #include "Timer.h"
+#include "uring.h"
 
 #ifdef WITH_TEXTDECORATOR
   #define RED(x) TD.red(x)
@@ -39,21 +68,258 @@
 
 
 
-static std::vector<std::string> infilenames;
-static std::vector<std::string> outfilenames;
+static FileList::List infilenames;
+static FileList::List outfilenames;
 
 /// Command-line options
 optparse::Values options;
 
+/// Print prettification
+static TextDecorator::TextDecorator TD{true, false};
+
+
+/**
+ * How workers read their input files
+ */
+enum class ReadEngine_t {
+  IFSTREAM,
+  IO_URING,
+  MMAP,
+};
+
+/**
+ * Whether workers stream whole files, or read single blocks at
+ * generated offsets (--pattern)
+ */
+enum class AccessPattern_t {
+  WHOLE_FILES,
+  SEQUENTIAL,
+  RANDOM,
+  STRIDED,
+};
+
+/**
+ * What is done to every file with --mode=metadata (--metadata-op)
+ */
+enum class MetadataOp_t {
+  /// stat() the path
+  STAT,
+  /// open() and close() the file
+  OPEN_CLOSE,
+  /// open(), fstat(), read the whole file, close()
+  OPEN_READ_CLOSE,
+};
+
+/**
+ * How output files are written (--write-variant)
+ */
+enum class WriteVariant_t {
+  /// Truncate, then extend the file with every write
+  SPARSE,
+  /// Delete the file and create a new one (new inode)
+  CREATE,
+  /// Write over the existing data in place (extends shorter files)
+  OVERWRITE,
+  /// Truncate and fallocate() the whole file before writing
+  PREALLOCATE,
+  /// Append to the end of the existing file
+  APPEND,
+};
+
+/**
+ * How written data is made durable (--sync)
+ */
+enum class Sync_t {
+  /// Writes only reach the page cache
+  NONE,
+  /// fsync() before closing each file
+  FSYNC_PER_FILE,
+  /// fdatasync() after every N writes (and before closing)
+  FDATASYNC_EVERY_N,
+  /// Open with O_DSYNC; every write waits for the device
+  ODSYNC,
+  /// Start writeback of each write with sync_file_range(), and wait for
+  /// the previous one
+  SYNC_FILE_RANGE,
+};
+
+/**
+ * How often each file is accessed (--distribution)
+ */
+enum class Distribution_t {
+  /// Every file once, in list order or shuffled
+  UNIFORM,
+  /// File i is drawn (i+1)^theta times less often than the first one
+  ZIPF,
+  /// x% of the files get (100-x)% of the draws, falling off smoothly
+  PARETO,
+  /// x% of the files share a fixed share of the draws evenly
+  HOTSET,
+};
+
+/**
+ * Benchmark settings which are derived from the command-line options
+ * once, before any worker is started
+ */
+struct Settings {
+  ReadEngine_t engine{ReadEngine_t::IFSTREAM};
+  /// Number of reads each worker keeps in flight (io_uring only)
+  size_t iodepth{1};
+  /// Bypass the page cache (O_DIRECT)
+  bool direct{false};
+  /// Offset/length alignment for O_DIRECT reads (largest sector size)
+  size_t direct_alignment{512};
+  /// Whole files, or single blocks (--pattern)
+  AccessPattern_t pattern{AccessPattern_t::WHOLE_FILES};
+  /// Size of read requests (chunk size for whole files, block size for
+  /// --pattern)
+  long int block_size{10*1024*1024l};
+  /// Byte range of each file used for single-block reads (0 = file end)
+  long int range_begin{0};
+  long int range_end{0};
+  /// Distance between consecutive reads for --pattern=stride
+  long int stride{1024*1024};
+  /// Open-loop target rate (--rate), in requests or bytes per second
+  /// (0 = closed loop, i.e. as fast as possible)
+  double rate_iops{0};
+  long int rate_bytes{0};
+  /// Start with one worker and add one every "ramp_interval" seconds
+  /// until the throughput stops growing (--ramp)
+  bool ramp{false};
+  float ramp_interval{5.f};
+  /// madvise() advice for every mapping (--engine=mmap)
+  std::vector<int> madvise_advice;
+  /// Copy mapped data out instead of touching one byte per page
+  bool mmap_copy{false};
+  /// Sampling frequency of the per-device log (--disklog)
+  float disk_hz{10.f};
+  /// Probe the page cache residency of the inputs every this many
+  /// seconds during a run (0 = only before the run)
+  float cache_probe_interval{0.f};
+  /// Drop all input/output files from the page cache before each run
+  bool evict_cache{false};
+  /// Check the block headers of "iobench generate --verify" data
+  bool verify{false};
+  /// Bytes written per output file (--mode=write)
+  long int write_size{1024*1024};
+  /// Share of every 4 KiB of written data which is zeros, and share of
+  /// 4 KiB units which repeat earlier ones (--buffer-compress-pct,
+  /// --dedupe-pct)
+  int compress_pct{0};
+  int dedupe_pct{0};
+  /// Per-file operation of --mode=metadata
+  MetadataOp_t metadata_op{MetadataOp_t::OPEN_CLOSE};
+  /// Whether iobench itself already looked up every input file (so the
+  /// dentry/inode caches are warm for --mode=metadata)
+  bool inputs_looked_up{false};
+  /// How output files are opened and extended (one per run)
+  WriteVariant_t write_variant{WriteVariant_t::SPARSE};
+  /// Durability of writes, and N for --sync=fdatasync-every-N
+  Sync_t sync{Sync_t::NONE};
+  long int sync_every{1};
+  /// Skewed draws with replacement instead of one pass over all files;
+  /// the parameter is theta (Zipf) or the hot fraction (Pareto, hot
+  /// set), and "hot_probability" the hot set's share of the draws
+  Distribution_t distribution{Distribution_t::UNIFORM};
+  double distribution_parameter{0.};
+  double hot_probability{0.};
+  /// Budget of a skewed run: requests in total, and/or seconds (0 = no
+  /// limit; without any, one request per file or block)
+  long int max_requests{0};
+  float runtime{0.f};
+};
+static Settings settings;
+
+
+/**
+ * Parse a byte count with an optional binary unit suffix, e.g. "4k",
+ * "64KiB", "10M", "1g"
+ *
+ * @returns FALSE IFF "text" is not a valid size
+ */
+bool ParseSize(const std::string& text, long int& bytes)
+{
+  size_t unit_position;
+  long long number;
+  try {
+    number = std::stoll(text, &unit_position);
+  } catch (const std::logic_error&) {
+    return false;
+  }
+  if (number < 0)
+    return false;
+
+  std::string unit{text.substr(unit_position)};
+  std::transform(unit.begin(), unit.end(), unit.begin(), ::tolower);
+  const std::vector<std::string> units{"", "k", "m", "g", "t"};
+  for (size_t i = 0; i < units.size(); ++i) {
+    if (unit == units[i] or
+        (i > 0 and (unit == units[i]+"b" or unit == units[i]+"ib"))) {
+      bytes = number << (10*i);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+/**
+ * The I/O counters of one block device, as listed in /proc/diskstats
+ * (see Documentation/admin-guide/iostats.rst in the kernel sources).
+ * All counters are cumulative since boot, except "ios_in_progress".
+ */
+struct DiskStats {
+  size_t reads_completed;
+  size_t reads_merged;
+  size_t sectors_read;
+  size_t milliseconds_reading;
+  size_t writes_completed;
+  size_t writes_merged;
+  size_t sectors_written;
+  size_t milliseconds_writing;
+  size_t ios_in_progress;
+  /// Time during which at least one request was in flight ("io_ticks")
+  size_t milliseconds_doing_io;
+  /// Sum of the time all requests spent in flight ("time in queue")
+  size_t weighted_milliseconds_doing_io;
+};
+
+/// /proc/diskstats counts in 512-byte units, whatever the actual
+/// sector size of a device is
+constexpr size_t DISKSTATS_SECTOR_SIZE{512};
+
 
 /**
  * Information about a system disk
  */
 struct Disk {
   std::string name;
-  size_t current_sectors_read;
-  size_t last_sectors_read;
+  DiskStats current;
+  DiskStats last;
   size_t bytes_per_sector;
+  /// Holds (some of) the input files
+  bool backs_inputs{false};
+  /// Counters at the start of the current benchmark run
+  DiskStats run_start{};
+};
+
+
+/**
+ * What a disk did between the last two DisksIOInfo::update() calls
+ */
+struct DiskActivity {
+  float read_iops;
+  float write_iops;
+  /// Bytes per second
+  float read_speed;
+  float write_speed;
+  /// Bytes per completed request (reads and writes)
+  float average_request_size;
+  /// Average number of requests in flight
+  float average_queue_depth;
+  /// Fraction of the time with at least one request in flight, in [0,1]
+  float utilization;
+  size_t in_flight;
 };
 
 
@@ -62,33 +328,38 @@ struct Disk {
  */
 struct DisksIOInfo {
   DisksIOInfo()
-    : m_state{InfoState_t::INIT}
+    : m_state{InfoState_t::INIT},
+      m_diskstats_fd{-1},
+      m_buffer_fill{0}
   {
     init();
   }
 
+  ~DisksIOInfo()
+  {
+    if (m_diskstats_fd >= 0)
+      close(m_diskstats_fd);
+  }
+
+  DisksIOInfo(const DisksIOInfo&) = delete;
+  DisksIOInfo& operator=(const DisksIOInfo&) = delete;
+
   void init()
   {
-    /// Get disks info
-    std::ifstream diskstats{"/proc/diskstats"};
-    if (diskstats.bad() or not diskstats.is_open()) {
+    /// Get disks info; the descriptor stays open for all updates
+    m_diskstats_fd = open("/proc/diskstats", O_RDONLY | O_CLOEXEC);
+    if (m_diskstats_fd < 0 or not ReadDiskstats()) {
       m_state = InfoState_t::NO_DISKS_AVAILABLE;
       return;
     }
-    while (not diskstats.eof()) {
-      size_t dummy_int;
-      size_t sectors_read;
-      std::string disk_name;
-      std::string dummy_string;
-
-      /// Example:
-      ///    8       4 sda4 5 0 28 108 0 0 0 0 0 108 108
-      ///         NAME--^       ^--sectors_read
-      diskstats >> dummy_int >> dummy_int >> disk_name
-                >> dummy_int >> dummy_int >> sectors_read;
-      std::getline(diskstats, dummy_string);
-      if (diskstats.eof())
-        break;
+
+    const char* position{m_buffer.data()};
+    const char* const end{position + m_buffer_fill};
+    const char* name;
+    size_t name_length;
+    DiskStats stats;
+    while (ParseDiskstatsLine(position, end, name, name_length, stats)) {
+      const std::string disk_name{name, name_length};
 
       /// Ignore "loopXXX" entries
       if (std::strncmp(disk_name.c_str(), "loop", std::strlen("loop")) == 0)
@@ -106,14 +377,19 @@ struct DisksIOInfo {
       hw_sector_size >> bytes_per_sector;
       hw_sector_size.close();
       
-      m_disks.emplace_back(Disk{disk_name, sectors_read, 0, bytes_per_sector});
+      m_disks.emplace_back(Disk{disk_name, stats, stats, bytes_per_sector});
     }
+    IndexLines();
 
-    diskstats.close();
-
+    m_current_time = std::chrono::steady_clock::now();
+    m_last_time    = m_current_time;
     m_state = InfoState_t::HAVE_DISKS;
   }
 
+  /**
+   * Take a new sample of all disks. This does not allocate (unless
+   * the set of devices changes), so it can run at 100Hz and more.
+   */
   void update()
   {
     if (m_state != InfoState_t::HAVE_DISKS) {
@@ -121,52 +397,194 @@ struct DisksIOInfo {
       return;
     }
 
+    m_last_time    = m_current_time;
+    m_current_time = std::chrono::steady_clock::now();
+    for (auto& disk : m_disks)
+      disk.last = disk.current;
+
     /// Get disks info
-    std::ifstream diskstats{"/proc/diskstats"};
-    if (diskstats.bad() or not diskstats.is_open()) {
-      for (auto& disk : m_disks) {
-        disk.current_sectors_read = 0;
-        disk.last_sectors_read    = 0;
-      }
-    }
-    while (not diskstats.eof()) {
-      size_t dummy_int;
-      size_t sectors_read;
-      std::string disk_name;
-      std::string dummy_string;
-
-      /// Example:
-      ///    8       4 sda4 5 0 28 108 0 0 0 0 0 108 108
-      ///         NAME--^       ^--sectors_read
-      diskstats >> dummy_int >> dummy_int >> disk_name
-                >> dummy_int >> dummy_int >> sectors_read;
-      std::getline(diskstats, dummy_string);
-      if (diskstats.eof())
-        break;
+    if (not ReadDiskstats())
+      return;
+    if (not ParseSample()) {
+      /// Devices were added or removed; locate our disks again
+      IndexLines();
+      ParseSample();
+    }
+  }
 
-      for (auto& disk : m_disks) {
-        if (disk.name == disk_name) {
-          disk.last_sectors_read    = disk.current_sectors_read;
-          disk.current_sectors_read = sectors_read;
-        }
-      }
+  /**
+   * Largest bytes-per-sector value of all disks (0 if there are none);
+   * O_DIRECT reads aligned to this work on every disk
+   */
+  size_t getLargestSectorSize() const
+  {
+    size_t largest = 0;
+    for (const auto& disk : m_disks)
+      largest = std::max(largest, disk.bytes_per_sector);
+    return largest;
+  }
+
+  /**
+   * Mark the disks which hold the input files; from now on, only they
+   * are considered by getBackingDisksRead()
+   */
+  void setBackingDisks(const std::set<std::string>& names)
+  {
+    for (auto& disk : m_disks)
+      disk.backs_inputs = (names.count(disk.name) > 0);
+  }
+
+  bool hasBackingDisks() const
+  {
+    return std::any_of(m_disks.begin(), m_disks.end(),
+                       [](const Disk& disk) { return disk.backs_inputs; });
+  }
+
+  /**
+   * Combined read speed of the disks which hold the input files, in
+   * bytes per second. Without known backing disks, this falls back to
+   * getFastestDiskRead().
+   */
+  size_t getBackingDisksRead() const
+  {
+    if (not hasBackingDisks())
+      return getFastestDiskRead();
+    size_t read = 0;
+    for (const auto& disk : m_disks)
+      if (disk.backs_inputs)
+        read += getActivity(disk).read_speed;
+    return read;
+  }
+
+  /// Remember the current counters as the start of a benchmark run
+  void markRunStart()
+  {
+    for (auto& disk : m_disks)
+      disk.run_start = disk.current;
+  }
+
+  /// Print how much each backing disk read since markRunStart()
+  void printRunReads() const
+  {
+    for (const auto& disk : m_disks) {
+      if (not disk.backs_inputs)
+        continue;
+      const size_t bytes{(disk.current.sectors_read - 
+                          disk.run_start.sectors_read) *
+                         DISKSTATS_SECTOR_SIZE};
+      std::cout << "  " << disk.name << ": " 
+                << std::setprecision(1) << std::fixed
+                << bytes / (1024.f*1024) << " MB read from disk in "
+                << disk.current.reads_completed - 
+                   disk.run_start.reads_completed 
+                << " requests" << std::endl;
     }
-    diskstats.close();
   }
 
+  /// Highest read speed of any disk in bytes per second
   size_t getFastestDiskRead() const
   {
     size_t fastest = 0;
 
     for (const auto& disk : m_disks) {
-      const size_t read = disk.bytes_per_sector * 
-                         (disk.current_sectors_read - disk.last_sectors_read);
+      const size_t read = getActivity(disk).read_speed;
       if (read > fastest)
         fastest = read;
     }
     return fastest;
   }
 
+  /// Rates of a disk between the last two update() calls
+  DiskActivity getActivity(const Disk& disk) const
+  {
+    DiskActivity activity{};
+    activity.in_flight = disk.current.ios_in_progress;
+    const float milliseconds{std::chrono::duration<float, std::milli>(
+                               m_current_time - m_last_time).count()};
+    if (milliseconds <= 0.f)
+      return activity;
+
+    const DiskStats& now{disk.current};
+    const DiskStats& before{disk.last};
+    const size_t reads{now.reads_completed - before.reads_completed};
+    const size_t writes{now.writes_completed - before.writes_completed};
+    const size_t read_bytes{(now.sectors_read - before.sectors_read) *
+                            DISKSTATS_SECTOR_SIZE};
+    const size_t written_bytes{(now.sectors_written - 
+                                before.sectors_written) *
+                               DISKSTATS_SECTOR_SIZE};
+
+    activity.read_iops   = reads * 1e3f / milliseconds;
+    activity.write_iops  = writes * 1e3f / milliseconds;
+    activity.read_speed  = read_bytes * 1e3f / milliseconds;
+    activity.write_speed = written_bytes * 1e3f / milliseconds;
+    if (reads + writes > 0)
+      activity.average_request_size = static_cast<float>(read_bytes + 
+                                                         written_bytes) /
+                                       (reads + writes);
+    activity.average_queue_depth = 
+        (now.weighted_milliseconds_doing_io - 
+         before.weighted_milliseconds_doing_io) / milliseconds;
+    activity.utilization = std::min(1.f,
+        (now.milliseconds_doing_io - before.milliseconds_doing_io) /
+        milliseconds);
+    return activity;
+  }
+
+  /**
+   * Print one line per disk which was busy since the last update()
+   *
+   * @param indent Prefix for every line
+   */
+  void printActivity(const std::string& indent) const
+  {
+    for (const auto& disk : m_disks) {
+      const DiskActivity activity{getActivity(disk)};
+      if (activity.utilization == 0.f and activity.in_flight == 0)
+        continue;
+      std::cout << indent << disk.name << ":"
+                << std::setprecision(1) << std::fixed
+                << " read " << std::setw(7) << activity.read_iops 
+                << " IOPS " << std::setw(7) 
+                << activity.read_speed / (1024*1024) << " MB/s,"
+                << " write " << std::setw(7) << activity.write_iops 
+                << " IOPS " << std::setw(7)
+                << activity.write_speed / (1024*1024) << " MB/s,"
+                << " req " << std::setw(7) 
+                << activity.average_request_size / 1024 << " KiB,"
+                << " qd " << std::setw(5) << activity.average_queue_depth
+                << ", util " << std::setw(5) << activity.utilization*100 
+                << "%";
+      if (activity.utilization >= 0.95f)
+        std::cout << " (saturated)";
+      std::cout << std::endl;
+    }
+  }
+
+
+  /**
+   * Write one line per disk with the activity since the last update()
+   *
+   * @param seconds Timestamp for the lines
+   */
+  void logActivity(std::ostream& log, float seconds) const
+  {
+    for (const auto& disk : m_disks) {
+      const DiskActivity activity{getActivity(disk)};
+      log << seconds
+          << '\t' << disk.name
+          << '\t' << activity.read_iops
+          << '\t' << activity.read_speed
+          << '\t' << activity.write_iops
+          << '\t' << activity.write_speed
+          << '\t' << activity.average_request_size
+          << '\t' << activity.average_queue_depth
+          << '\t' << activity.utilization
+          << '\t' << activity.in_flight
+          << '\n';
+    }
+  }
+
 
   enum class InfoState_t {
     INIT,
@@ -174,11 +592,298 @@ struct DisksIOInfo {
     NO_DISKS_AVAILABLE,
   };
   InfoState_t m_state;
-
   std::vector<Disk> m_disks;
+  /// Times of the last two update() calls
+  std::chrono::steady_clock::time_point m_current_time;
+  std::chrono::steady_clock::time_point m_last_time;
+
+ private:
+  /**
+   * Read all of /proc/diskstats into m_buffer (which only grows if the
+   * file does not fit)
+   *
+   * @returns FALSE IFF the file cannot be read
+   */
+  bool ReadDiskstats()
+  {
+    if (m_buffer.empty())
+      m_buffer.resize(64*1024);
+    for (;;) {
+      const ssize_t bytes{pread(m_diskstats_fd, m_buffer.data(), 
+                                m_buffer.size(), 0)};
+      if (bytes < 0)
+        return false;
+      if (static_cast<size_t>(bytes) < m_buffer.size()) {
+        m_buffer_fill = bytes;
+        return true;
+      }
+      m_buffer.resize(2 * m_buffer.size());
+    }
+  }
+
+  /**
+   * Parse the current sample into "current" of every disk, using the
+   * line index from IndexLines()
+   *
+   * @returns FALSE IFF the lines do not match the index anymore
+   */
+  bool ParseSample()
+  {
+    const char* position{m_buffer.data()};
+    const char* const end{position + m_buffer_fill};
+    const char* name;
+    size_t name_length;
+    DiskStats stats;
+    size_t line{0};
+    size_t found{0};
+    while (ParseDiskstatsLine(position, end, name, name_length, stats)) {
+      if (line < m_line_to_disk.size() and m_line_to_disk[line] >= 0) {
+        Disk& disk{m_disks[m_line_to_disk[line]]};
+        if (name_length != disk.name.size() or
+            std::memcmp(name, disk.name.data(), name_length) != 0)
+          return false;
+        disk.current = stats;
+        ++found;
+      }
+      ++line;
+    }
+    return (found == m_disks.size());
+  }
+
+  /// Find the line of every disk in the current sample (disks which
+  /// have disappeared are dropped, together with their counters)
+  void IndexLines()
+  {
+    m_line_to_disk.clear();
+    const char* position{m_buffer.data()};
+    const char* const end{position + m_buffer_fill};
+    const char* name;
+    size_t name_length;
+    DiskStats stats;
+    while (ParseDiskstatsLine(position, end, name, name_length, stats)) {
+      int disk_index{-1};
+      for (size_t i = 0; i < m_disks.size(); ++i) {
+        if (name_length == m_disks[i].name.size() and
+            std::memcmp(name, m_disks[i].name.data(), name_length) == 0)
+          disk_index = i;
+      }
+      m_line_to_disk.push_back(disk_index);
+    }
+    /// Missing disks must not make every ParseSample() fail
+    std::vector<bool> present(m_disks.size(), false);
+    for (const int index : m_line_to_disk)
+      if (index >= 0)
+        present[index] = true;
+    for (size_t i = 0; i < m_disks.size(); ++i) {
+      if (not present[i]) {
+        std::cerr << "! Disk " << m_disks[i].name << " disappeared" 
+                  << std::endl;
+        m_disks.erase(m_disks.begin() + i);
+        IndexLines();
+        return;
+      }
+    }
+  }
+
+  /// Parse a decimal number and skip the whitespace before it
+  static size_t ParseNumber(const char*& position, const char* end)
+  {
+    while (position < end and (*position == ' ' or *position == '\t'))
+      ++position;
+    size_t number{0};
+    while (position < end and *position >= '0' and *position <= '9')
+      number = 10*number + (*position++ - '0');
+    return number;
+  }
+
+  /**
+   * Parse the next line of /proc/diskstats
+   *
+   * @param position Start of the line; moved to the next line
+   * @param name Receives the start of the device name (not terminated)
+   *
+   * @returns FALSE IFF there is no line left
+   */
+  static bool ParseDiskstatsLine(const char*& position,
+                                 const char* end,
+                                 const char*& name,
+                                 size_t& name_length,
+                                 DiskStats& stats)
+  {
+    /// Example (newer kernels append discard/flush fields, which we skip):
+    ///    8       4 sda4 5 0 28 108 0 0 0 0 0 108 108
+    ///         NAME--^  ^--the 11 DiskStats fields, in order
+    if (position >= end)
+      return false;
+    ParseNumber(position, end);
+    ParseNumber(position, end);
+    while (position < end and *position == ' ')
+      ++position;
+    name = position;
+    while (position < end and *position != ' ' and *position != '\n')
+      ++position;
+    name_length = position - name;
+
+    stats.reads_completed                = ParseNumber(position, end);
+    stats.reads_merged                   = ParseNumber(position, end);
+    stats.sectors_read                   = ParseNumber(position, end);
+    stats.milliseconds_reading           = ParseNumber(position, end);
+    stats.writes_completed               = ParseNumber(position, end);
+    stats.writes_merged                  = ParseNumber(position, end);
+    stats.sectors_written                = ParseNumber(position, end);
+    stats.milliseconds_writing           = ParseNumber(position, end);
+    stats.ios_in_progress                = ParseNumber(position, end);
+    stats.milliseconds_doing_io          = ParseNumber(position, end);
+    stats.weighted_milliseconds_doing_io = ParseNumber(position, end);
+
+    while (position < end and *position != '\n')
+      ++position;
+    if (position < end)
+      ++position;
+    return (name_length > 0);
+  }
+
+  int m_diskstats_fd;
+  /// Raw contents of /proc/diskstats, and how much of it is valid
+  std::vector<char> m_buffer;
+  size_t m_buffer_fill;
+  /// For each line of /proc/diskstats: index into m_disks, or -1
+  std::vector<int> m_line_to_disk;
 };
 
 
+/**
+ * Find the disks (as listed in /sys/block) which hold a block device:
+ * a partition resolves to its parent disk, and a device-mapper or md
+ * device to the disks of all its slaves (recursively)
+ *
+ * @param sysfs_path Directory (or link to it) of the device in sysfs
+ * @param disks Receives the disk names
+ */
+void CollectBackingDisks(const std::string& sysfs_path,
+                         std::set<std::string>& disks)
+{
+  char resolved[PATH_MAX];
+  if (not realpath(sysfs_path.c_str(), resolved))
+    return;
+  std::string path{resolved};
+
+  /// A partition's directory is inside that of its disk
+  if (access((path + "/partition").c_str(), F_OK) == 0)
+    path = path.substr(0, path.rfind('/'));
+
+  bool have_slaves{false};
+  if (DIR* slaves = opendir((path + "/slaves").c_str())) {
+    while (const dirent* entry = readdir(slaves)) {
+      if (entry->d_name[0] == '.')
+        continue;
+      have_slaves = true;
+      CollectBackingDisks(path + "/slaves/" + entry->d_name, disks);
+    }
+    closedir(slaves);
+  }
+  if (not have_slaves)
+    disks.insert(path.substr(path.rfind('/') + 1));
+}
+
+/// sysfs directory of a device number (may not exist, e.g. for tmpfs
+/// or NFS, whose st_dev is not a block device)
+std::string SysfsBlockPath(dev_t device)
+{
+  return "/sys/dev/block/" + std::to_string(major(device)) + ":" +
+         std::to_string(minor(device));
+}
+
+/**
+ * Find the disks which hold the input files, print which device holds
+ * how much of them, and restrict cache detection to these disks
+ */
+void MapInputsToDisks(DisksIOInfo& disks_info)
+{
+  struct DeviceUsage {
+    size_t files;
+    size_t bytes;
+  };
+  /// stat() every input, in chunks which a pool of threads takes turns
+  /// on (like PageCache::ForEachFile); every thread counts on its own
+  const size_t threads{std::max<size_t>(1, std::min<size_t>(
+                         std::thread::hardware_concurrency(),
+                         (infilenames.size() + PageCache::CHUNK_FILES - 1) /
+                         PageCache::CHUNK_FILES))};
+  std::atomic<size_t> next_chunk{0};
+  std::vector<std::map<dev_t, DeviceUsage>> thread_devices(threads);
+  std::vector<size_t> thread_unreadable(threads, 0);
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&, t]() {
+      for (;;) {
+        const size_t begin{next_chunk.fetch_add(PageCache::CHUNK_FILES)};
+        if (begin >= infilenames.size())
+          return;
+        const size_t end{std::min(begin + PageCache::CHUNK_FILES,
+                                  infilenames.size())};
+        for (size_t i = begin; i < end; ++i) {
+          struct stat file_stat;
+          if (stat(infilenames[i], &file_stat) != 0) {
+            ++thread_unreadable[t];
+            continue;
+          }
+          DeviceUsage& usage{thread_devices[t][file_stat.st_dev]};
+          ++usage.files;
+          usage.bytes += file_stat.st_size;
+        }
+      }
+    });
+  }
+  for (auto& thread : pool)
+    thread.join();
+
+  std::map<dev_t, DeviceUsage> devices;
+  size_t unreadable{0};
+  for (size_t t = 0; t < threads; ++t) {
+    for (const auto& device : thread_devices[t]) {
+      DeviceUsage& usage{devices[device.first]};
+      usage.files += device.second.files;
+      usage.bytes += device.second.bytes;
+    }
+    unreadable += thread_unreadable[t];
+  }
+
+  std::set<std::string> all_disks;
+  std::cout << "Input files by device:" << std::endl;
+  for (const auto& device : devices) {
+    const std::string path{SysfsBlockPath(device.first)};
+    std::set<std::string> disks;
+    CollectBackingDisks(path, disks);
+    all_disks.insert(disks.begin(), disks.end());
+
+    std::cout << "  ";
+    char resolved[PATH_MAX];
+    if (disks.empty() or not realpath(path.c_str(), resolved)) {
+      std::cout << "device " << major(device.first) << ":"
+                << minor(device.first) << " (no block device)";
+    } else {
+      const std::string device_path{resolved};
+      std::cout << device_path.substr(device_path.rfind('/') + 1) << " (on";
+      for (const auto& disk : disks)
+        std::cout << " " << disk;
+      std::cout << ")";
+    }
+    std::cout << ": " << device.second.files << " files, "
+              << std::setprecision(1) << std::fixed
+              << device.second.bytes / (1024.f*1024) << " MB" << std::endl;
+  }
+  if (unreadable > 0)
+    std::cout << "  (" << unreadable << " files cannot be read)" << std::endl;
+
+  disks_info.setBackingDisks(all_disks);
+  if (not disks_info.hasBackingDisks()) {
+    std::cout << "! No input file is on a local disk; cache detection "
+              << "compares against all disks" << std::endl;
+  }
+}
+
+
 /**
  * A module to get information about the current CPU usage
  * https://stackoverflow.com/a/64166
@@ -239,518 +944,3933 @@ struct CPUUsageInfo {
 
 
 /**
- * A parallelizable data-reader
+ * A heap buffer whose start address is aligned to a given boundary
  */
-struct Worker {
-  Worker(const std::vector<int>& indices) 
-    : m_indices{indices},
-      m_status{WorkerStatus_t::INIT},
-      m_workmode{WorkMode_t::ONLY_READ},
-      m_done{0},
-      m_worker_ID{s_running_workers_ID++}
-  { }
+struct AlignedBuffer {
+  AlignedBuffer(size_t size, size_t alignment)
+    : m_size{size}
+  {
+    /// std::aligned_alloc wants the size to be a multiple of the alignment
+    const size_t padded_size{(size + alignment - 1) / alignment * alignment};
+    m_data = static_cast<char*>(std::aligned_alloc(alignment, padded_size));
+    if (not m_data)
+      throw std::bad_alloc();
+  }
 
-  Worker(Worker&& rhs)
+  AlignedBuffer(AlignedBuffer&& rhs)
+    : m_data{rhs.m_data},
+      m_size{rhs.m_size}
   {
-    m_indices   = std::move(rhs.m_indices);
-    m_status    = rhs.m_status;
-    m_done      = rhs.m_done;
-    m_worker_ID = rhs.m_worker_ID;
+    rhs.m_data = nullptr;
+    rhs.m_size = 0;
   }
 
-  void Start()
+  AlignedBuffer(const AlignedBuffer&) = delete;
+  AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+  ~AlignedBuffer()
   {
-    if (m_status == WorkerStatus_t::RUNNING)
-      return;
-    m_status = WorkerStatus_t::RUNNING;
-    m_thread_ptr = std::make_unique<std::thread>(&Worker::Loop, this);
+    std::free(m_data);
   }
 
-  void Stop() 
+  char* m_data;
+  size_t m_size;
+};
+
+
+/**
+ * A fixed set of equally-sized aligned buffers which are handed out
+ * by index
+ */
+struct AlignedBufferPool {
+  AlignedBufferPool(size_t count, size_t size, size_t alignment)
   {
-    m_status = WorkerStatus_t::STOPPING;
-    if (m_thread_ptr and m_thread_ptr->joinable())
-      m_thread_ptr->join();
+    for (size_t i = 0; i < count; ++i) {
+      m_buffers.emplace_back(size, alignment);
+      m_free.push_back(count-1-i);
+    }
   }
 
-  void Loop() 
+  bool empty() const
   {
-    for (const auto random_index : m_indices) {
-      if (m_status != WorkerStatus_t::RUNNING) {
-        m_status = WorkerStatus_t::FINISHED;
-        return;
-      }
+    return m_free.empty();
+  }
 
-      std::ifstream ifs;
-      std::string content;
-      std::ofstream ofs;
+  /// Take a free buffer (pool must not be empty)
+  unsigned Acquire()
+  {
+    const unsigned index{m_free.back()};
+    m_free.pop_back();
+    return index;
+  }
 
-      if (m_workmode == WorkMode_t::ONLY_READ or
-          m_workmode == WorkMode_t::READ_AND_WRITE) {
-        /// Open random file
+  void Release(unsigned index)
+  {
+    m_free.push_back(index);
+  }
 
-        //std::cout << infilenames[random_index] << std::endl;
-        ifs.open(infilenames[random_index], std::ifstream::binary);
-        if (ifs.bad() or not ifs.is_open()) {
-          std::cerr << "Cannot read" << infilenames[random_index] 
-                    << std::endl;
-          ++m_done;
-          continue;
-        }
-        ifs.seekg(0, std::ios_base::end);
-        const auto length{ifs.tellg()};
-        ifs.seekg(0, std::ios_base::beg);
-        /// Read in chunks
-        long int current_position{0};
-        long int still_to_read{length};
-        while (still_to_read > 0) {
-          /// Maximum chunk size 10MB
-          const long int read_size{std::min(still_to_read, 10*1024*1024l)};
-
-          content.resize(read_size);
-          ifs.read((char*)&(content.c_str()[0]), read_size);
-
-          current_position += read_size;
-          still_to_read -= read_size;
+  char* Data(unsigned index)
+  {
+    return m_buffers[index].m_data;
+  }
 
-          /// Log data
-          m_data_throughput_logger.AddSample(read_size);
-        }
+  std::vector<AlignedBuffer> m_buffers;
+  std::vector<unsigned> m_free;
+};
 
-        //ifs.open(infilenames[random_index], std::ifstream::binary);
-        //if (ifs.bad() or not ifs.is_open()) {
-        //  std::cerr << "Cannot read" << infilenames[random_index] 
-        //            << std::endl;
-        //  continue;
-        //}
-        ///// Read entire file content
-        //content = std::string{std::istreambuf_iterator<char>(ifs),
-        //                      std::istreambuf_iterator<char>()};
 
-        ifs.close();
-      }
-      if (m_workmode == WorkMode_t::ONLY_WRITE) {
-        content.resize(std::stoi(options["write-size"]));
+/**
+ * One single-block read
+ */
+struct BlockRequest {
+  /// Position of the file in the BlockSpace
+  int file;
+  long int offset;
+  long int length;
+};
 
-        ofs.open(outfilenames[random_index], std::ofstream::binary);
-        if (ofs.bad() or not ofs.is_open()) {
-          std::cerr << "Cannot write " << outfilenames[random_index] 
-                    << std::endl;
-          continue;
-        }
-        ofs.write(content.c_str(), content.size());
-        ofs.close();
-        /// Log data
-        m_data_throughput_logger.AddSample(content.size());
-      }
-      if (m_workmode == WorkMode_t::READ_AND_WRITE) {
-        ofs.open(outfilenames[random_index], std::ofstream::binary);
-        if (ofs.bad() or not ofs.is_open()) {
-          std::cerr << "Cannot write " << outfilenames[random_index] 
-                    << std::endl;
-          continue;
-        }
-        ofs.write(content.c_str(), content.size());
-        ofs.close();
-        /// Log data
-        m_data_throughput_logger.AddSample(content.size());
-      }
 
-      ++m_done;
-    }
+/**
+ * All blocks of all input files (within --offset-range), numbered
+ * consecutively file after file
+ */
+struct BlockSpace {
+  BlockSpace()
+    : m_first_block{0}
+  { }
 
-    m_status = WorkerStatus_t::FINISHED;
+  /**
+   * Append a file
+   *
+   * @param index Index into "infilenames"
+   * @param file_size Size of the file in bytes
+   */
+  void Add(int index, long int file_size)
+  {
+    const long int end{settings.range_end > 0 
+                       ? std::min(settings.range_end, file_size)
+                       : file_size};
+    if (end <= settings.range_begin)
+      return;
+
+    const long int blocks{(end - settings.range_begin + 
+                           settings.block_size - 1) / settings.block_size};
+    m_files.push_back(index);
+    m_range_ends.push_back(end);
+    m_first_block.push_back(m_first_block.back() + blocks);
   }
 
-  size_t getDoneCount() const
+  long int size() const
   {
-    return m_done;
+    return m_first_block.back();
   }
 
-  float getThroughput()
+  /// Translate a block number into a file and an offset
+  BlockRequest At(long int block) const
   {
-    return m_data_throughput_logger.FPS(1.f);
+    const int file{static_cast<int>(std::upper_bound(m_first_block.begin(),
+                                                     m_first_block.end(),
+                                                     block)
+                                    - m_first_block.begin()) - 1};
+    const long int offset{settings.range_begin + 
+                          (block - m_first_block[file])*settings.block_size};
+    return BlockRequest{file, offset, std::min(settings.block_size,
+                                               m_range_ends[file] - offset)};
   }
 
-  size_t isDone() const
+  /// Indices into "infilenames"
+  std::vector<int> m_files;
+  /// End of the used byte range, per file
+  std::vector<long int> m_range_ends;
+  /// Number of the first block of each file (plus one past the end)
+  std::vector<long int> m_first_block;
+  /// Read-only descriptor of each file, shared by all workers (-1 if
+  /// the file could not be opened)
+  std::vector<int> m_fds;
+  /// Shared read-only mapping of each file for --engine=mmap (NULLPTR
+  /// if the file is empty or cannot be mapped)
+  std::vector<char*> m_maps;
+  std::vector<size_t> m_map_lengths;
+};
+static BlockSpace block_space;
+
+
+/**
+ * Shared state of skewed access (--distribution): how often which file
+ * and which part of a file is drawn, and the budget which all workers
+ * draw against. Draws are with replacement, so a run ends when the
+ * budget is spent rather than when every file was read. The first file
+ * in the work list (or BlockSpace) is the most popular one.
+ */
+struct SkewedAccess {
+  /// Number of parts of a file between which block offsets are skewed
+  static constexpr size_t OFFSET_BUCKETS{4096};
+
+  /// Weights of "n" items according to --distribution
+  static std::vector<double> Weights(size_t n)
   {
-    return (m_status == WorkerStatus_t::FINISHED);
+    switch (settings.distribution) {
+      case Distribution_t::ZIPF:
+        return Distribution::Zipf(n, settings.distribution_parameter);
+      case Distribution_t::PARETO:
+        return Distribution::Pareto(n, settings.distribution_parameter);
+      case Distribution_t::HOTSET:
+        return Distribution::HotSet(n, settings.distribution_parameter,
+                                    settings.hot_probability);
+      default:
+        return std::vector<double>(n, 1.);
+    }
   }
 
-  enum class WorkerStatus_t {
-    INIT,
-    RUNNING,
-    STOPPING,
-    FINISHED,
-  };
+  /**
+   * Prepare a run
+   *
+   * @param indices Files to draw from, most popular first
+   * @param with_offsets Also skew block offsets within files (--pattern)
+   */
+  void Setup(const std::vector<int>& indices, bool with_offsets)
+  {
+    const std::vector<double> weights{Weights(indices.size())};
+    m_files.Build(weights);
+    m_indices = indices;
+    if (with_offsets)
+      m_offsets.Build(Weights(OFFSET_BUCKETS));
+    m_requests = settings.max_requests;
+    m_seconds  = settings.runtime;
+    if (m_requests == 0 and m_seconds == 0.f)
+      m_requests = (with_offsets ? block_space.size() : indices.size());
+    m_remaining.store(m_requests);
 
-  enum class WorkMode_t {
-    ONLY_READ,
-    ONLY_WRITE,
-    READ_AND_WRITE,
-    DONT_DO_SHIT,
-  };
+    std::cout << "Skewed access (" << options["distribution"] << "): the "
+              << "hottest 1% / 10% / 20% of the files receive "
+              << std::setprecision(1) << std::fixed
+              << 100 * Distribution::TopShare(weights, .01) << "% / "
+              << 100 * Distribution::TopShare(weights, .1) << "% / "
+              << 100 * Distribution::TopShare(weights, .2)
+              << "% of the requests" << std::endl
+              << "Drawing with replacement until ";
+    if (m_requests > 0)
+      std::cout << m_requests << " requests"
+                << (m_seconds > 0.f ? " or " : "");
+    if (m_seconds > 0.f)
+      std::cout << m_seconds << " seconds";
+    std::cout << " are done." << std::endl;
+  }
 
-  void setMode(WorkMode_t mode)
+  /// Start the clock of the time budget
+  void Start()
   {
-    m_workmode = mode;
+    m_deadline = std::chrono::steady_clock::now() +
+                 std::chrono::duration_cast<
+                   std::chrono::steady_clock::duration>(
+                     std::chrono::duration<float>(m_seconds));
   }
 
-  std::vector<int> m_indices;
-  WorkerStatus_t m_status;
-  WorkMode_t m_workmode;
-  std::unique_ptr<std::thread> m_thread_ptr;
-  size_t m_done;
+  /// Claim one request from the budget; returns FALSE IFF it is spent
+  bool Take()
+  {
+    if (m_seconds > 0.f and std::chrono::steady_clock::now() >= m_deadline)
+      return false;
+    return (m_requests == 0 or
+            m_remaining.fetch_sub(1, std::memory_order_relaxed) > 0);
+  }
 
-  FramesPerSecond::FPSEstimator m_data_throughput_logger;
+  /// Draw a file (index into "infilenames"/"outfilenames")
+  int DrawFile(std::mt19937_64& RNG) const
+  {
+    return m_indices[m_files.Sample(RNG())];
+  }
 
-  int m_worker_ID;
-  static int s_running_workers_ID;
-};
-/// Initialize static field
-int Worker::s_running_workers_ID = 0;
+  /// Draw a block: a file of the BlockSpace, then a part of that file,
+  /// then a block within that part
+  long int DrawBlock(std::mt19937_64& RNG) const
+  {
+    const uint32_t file{m_files.Sample(RNG())};
+    const uint64_t bucket{m_offsets.Sample(RNG())};
+    const uint64_t blocks{static_cast<uint64_t>(
+                            block_space.m_first_block[file+1] -
+                            block_space.m_first_block[file])};
+    const uint64_t begin{bucket * blocks / OFFSET_BUCKETS};
+    const uint64_t end{(bucket+1) * blocks / OFFSET_BUCKETS};
+    const uint64_t block{begin + (end > begin ? RNG() % (end - begin) : 0)};
+    return block_space.m_first_block[file] + block;
+  }
 
+  /// Share of the budget which is spent, in [0,1]
+  float Progress(size_t done, float seconds) const
+  {
+    float progress{0.f};
+    if (m_requests > 0)
+      progress = static_cast<float>(done) / m_requests;
+    if (m_seconds > 0.f)
+      progress = std::max(progress, seconds / m_seconds);
+    return std::min(progress, 1.f);
+  }
+
+  Distribution::AliasTable m_files;
+  Distribution::AliasTable m_offsets;
+  /// Work list positions of the files in "m_files"
+  std::vector<int> m_indices;
+  long int m_requests{0};
+  float m_seconds{0.f};
+  std::atomic<long int> m_remaining{0};
+  std::chrono::steady_clock::time_point m_deadline;
+};
+static SkewedAccess skewed_access;
 
 
 /**
- * A simple statistics module
+ * A worker's stream of block numbers for --pattern. A worker owns the
+ * share [first, first+count) of the BlockSpace; "seq" and "stride" read
+ * exactly the blocks in that share, "rand" reads "count" blocks drawn
+ * uniformly from the entire BlockSpace.
  */
-struct Statistificator
-{
-  void addSample(float sample)
-  {
-    m_samples.push_back(sample);
-  }
+struct BlockStream {
+  BlockStream(long int first, long int count, unsigned seed)
+    : m_first{first},
+      m_count{count},
+      m_next{0},
+      m_lane{0},
+      m_stride_blocks{std::max(1l, settings.stride / settings.block_size)},
+      m_RNG{seed},
+      m_distribution{0, std::max(0l, block_space.size() - 1)}
+  { }
 
-  /**
-   * Mean
-   */
-  float average() const
+  /// Get the next request; returns FALSE IFF the stream is exhausted
+  bool Next(BlockRequest& request)
   {
-    float result{0.f};
-    for (size_t i = 0; i < m_samples.size(); ++i) {
-      result += m_samples[i];
+    long int block;
+    switch (settings.pattern) {
+      case AccessPattern_t::RANDOM: {
+        if (settings.distribution != Distribution_t::UNIFORM) {
+          if (not skewed_access.Take())
+            return false;
+          block = skewed_access.DrawBlock(m_RNG);
+          break;
+        }
+        if (m_next >= m_count)
+          return false;
+        ++m_next;
+        block = m_distribution(m_RNG);
+        break;
+      }
+      case AccessPattern_t::STRIDED: {
+        /// Visit every m_stride_blocks'th block, then start over one
+        /// block further ("lane") until every block was read once
+        if (m_next >= m_count) {
+          ++m_lane;
+          m_next = m_lane;
+          if (m_lane >= m_stride_blocks or m_next >= m_count)
+            return false;
+        }
+        block = m_first + m_next;
+        m_next += m_stride_blocks;
+        break;
+      }
+      default: {
+        if (m_next >= m_count)
+          return false;
+        block = m_first + m_next++;
+        break;
+      }
     }
-    return result/m_samples.size();
+    request = block_space.At(block);
+    return true;
   }
 
-  /**
-   * Mean without 5% highest / lowest outliers
-   */
-  float robustAverage() const
-  {
-    if (m_samples.size() < 100) {
-      std::cout << "! Statistificator only has " << m_samples.size() 
-                << " samples which is not really enough for reliable results!"
-                << std::endl;
-    }
+  long int m_first;
+  long int m_count;
+  long int m_next;
+  long int m_lane;
+  long int m_stride_blocks;
+  std::mt19937_64 m_RNG;
+  std::uniform_int_distribution<long int> m_distribution;
+};
 
-    /// Sort samples
-    std::vector<float> tmp{m_samples};
-    std::sort(tmp.begin(), tmp.end());
 
-    /// Compute average, leaving out the lowest/highest 5%
-    float result{0.f};
-    size_t sample_count{0};
-    for (size_t i = 0.05*tmp.size(); i < 0.95*tmp.size(); ++i) {
-      result += tmp[i];
-      ++sample_count;
-    }
+/**
+ * Round "value" up to the next multiple of "alignment"
+ */
+long int RoundUp(long int value, long int alignment)
+{
+  return (value + alignment - 1) / alignment * alignment;
+}
 
-    return result / sample_count;
-  }
 
-  /**
-   * Minimum
-   */
-  float min() const
+/**
+ * Per-worker source of write data, allocated and filled with random
+ * data once. Every 4 KiB unit of the buffer ends in a run of zeros of
+ * --buffer-compress-pct percent; the rest is incompressible. Before a
+ * write, Next() stamps every unit with a new unique number, except for
+ * --dedupe-pct percent of the units which get a constant stamp (and
+ * are thus exact copies of earlier units). Compressing or deduplicating
+ * storage therefore sees the requested ratios instead of all zeros.
+ */
+struct WritePayload {
+  /// Granularity of compression/dedupe control (a typical dedupe block)
+  static constexpr size_t UNIT{4096};
+
+  WritePayload(size_t size, uint64_t seed)
+    : m_buffer{static_cast<size_t>(RoundUp(std::max<size_t>(size, 1), UNIT)),
+               std::max<size_t>(settings.direct_alignment, UNIT)},
+      m_RNG{seed},
+      m_distribution{0, 99},
+      m_stamp{seed | 1, 0}
   {
-    float result{std::numeric_limits<float>::max()};
-    for (auto v : m_samples)
-      if (v < result)
-        result = v;
-    return result;
+    Generator::Xoshiro random{seed};
+    random.Fill(reinterpret_cast<uint64_t*>(m_buffer.m_data),
+                m_buffer.m_size / sizeof(uint64_t));
+    const size_t zeros{UNIT * settings.compress_pct / 100};
+    for (size_t unit = 0; unit < m_buffer.m_size; unit += UNIT)
+      std::memset(m_buffer.m_data + unit + UNIT - zeros, 0, zeros);
   }
 
   /**
-   * Minimum, but ignore the first 2 and the last value because those are often skewed by
-   * program init overhead.
+   * Prepare the buffer for the next write
+   *
+   * @param length Size of the write (at most the buffer size)
+   *
+   * @returns The data to write
    */
-  float robustMin() const
+  const char* Next(size_t length)
   {
-    if (m_samples.size() < 3) {
-      std::cerr << "Too few samples!" << std::endl;
-      return -1.f;
+    for (size_t unit = 0; unit < length; unit += UNIT) {
+      static const uint64_t DUPLICATE[2]{0, 0};
+      const bool duplicate{settings.dedupe_pct > 0 and
+                           m_distribution(m_RNG) < settings.dedupe_pct};
+      if (not duplicate)
+        ++m_stamp[1];
+      std::memcpy(m_buffer.m_data + unit,
+                  duplicate ? DUPLICATE : m_stamp,
+                  std::min(sizeof(m_stamp), length - unit));
     }
+    return m_buffer.m_data;
+  }
 
-    float result{std::numeric_limits<float>::max()};
-    for (size_t i = 2; i < m_samples.size() - 1; ++i)
-      if (m_samples[i] < result)
-        result = m_samples[i];
-    return result;
+  size_t size() const
+  {
+    return m_buffer.m_size;
   }
 
-  std::vector<float> m_samples;
+  AlignedBuffer m_buffer;
+  std::minstd_rand m_RNG;
+  std::uniform_int_distribution<int> m_distribution;
+  /// Worker-unique prefix and running counter
+  uint64_t m_stamp[2];
 };
 
 
-
 /**
- * Wrap a string in a pretty gift box
+ * Open a file for reading, with O_DIRECT if --direct is set. If the
+ * filesystem does not support O_DIRECT (e.g. tmpfs), the file is opened
+ * without it, and a warning is printed once.
+ *
+ * @returns A file descriptor, or -1
  */
-std::string Boxify(const std::string& content)
+int OpenForReading(const char* filename)
 {
-  size_t length{content.size()};
-  std::ostringstream oss;
-  oss << "╭"; for (size_t i = 0; i < length; ++i) oss << "─"; oss << "╮\n";
-  oss << "│";                oss << content;                  oss << "│\n"; 
-  oss << "╰"; for (size_t i = 0; i < length; ++i) oss << "─"; oss << "╯";
-  return oss.str();
-}
+  if (not settings.direct)
+    return open(filename, O_RDONLY);
 
+  const int fd{open(filename, O_RDONLY | O_DIRECT)};
+  if (fd >= 0 or errno != EINVAL)
+    return fd;
 
+  static std::once_flag warning;
+  std::call_once(warning, [&filename]() {
+    std::cerr << "! O_DIRECT is not supported for " << filename
+              << " (and maybe others); reading through the page cache"
+              << std::endl;
+  });
+  return open(filename, O_RDONLY);
+}
 
-int main (int argc, char* argv[])
+
+/**
+ * Map a whole file for reading (--engine=mmap) and apply the --madvise
+ * advice. Advice which the kernel rejects (e.g. MADV_HUGEPAGE without
+ * read-only THP support for files) is reported once and ignored.
+ *
+ * @returns The mapping, or MAP_FAILED
+ */
+char* MapForReading(int fd, size_t length)
 {
-  /// Print prettification
-  TextDecorator::TextDecorator TD{true, false};
+  void* map{mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0)};
+  if (map == MAP_FAILED)
+    return static_cast<char*>(MAP_FAILED);
 
-  std::cout << Boxify("                              "
-                      "iobench"
-                      "                              ") << std::endl;
+  for (const int advice : settings.madvise_advice) {
+    if (madvise(map, length, advice) != 0) {
+      static std::once_flag warning;
+      std::call_once(warning, [advice]() {
+        std::cerr << "! madvise(" << advice << ") failed ("
+                  << std::strerror(errno) << "); ignoring it" << std::endl;
+      });
+    }
+  }
+  return static_cast<char*>(map);
+}
 
-  /// Command line options
-  optparse::OptionParser parser;
-  parser.add_option("-i", "--infiles")
-        .dest("infiles")
-        .help("list of input filenames");
-  parser.add_option("-o", "--outfiles")
-        .dest("outfiles")
-        .help("list of output filenames");
-  parser.add_option("-j", "--jobs")
-        .type("int")
-        .set_default("1")
-        .dest("jobs")
-        .help("number of parallel workers to start");
-  parser.add_option("-s", "--workload-split")
-        .choices({"separate", "overlap", "same"})
-        .set_default("separate")
-        .dest("workload-split")
-        .help("how files are split between workers ([\"separate\"] / \"overlap\" / \"same\")");
-  parser.add_option("-r", "--randomize-files")
-        .action("store_true")
-        .set_default(false)
-        .dest("randomize")
-        .help("access listed files randomly instead of sequentially");
-  parser.add_option("-m", "--mode")
-        .choices({"read", "write", "readwrite"})
-        .set_default("read")
-        .dest("mode")
-        .help("Benchmark mode ([\"read\"] / \"write\" / \"readwrite\")");
-  parser.add_option("-w", "--write-size")
-        .type("int")
-        .set_default("1048576") /*1MiB*/
-        .dest("write-size")
-        .help("how many bytes to write per target file if --mode=\"write\"");
-  parser.add_option("-l", "--logfile")
-        .type("string")
-        .set_default("log.txt")
-        .dest("logfile")
-        .help("detailed logfile destination");
-  options = parser.parse_args(argc, argv);
 
 
-  /// Parse filenames for reading
-  std::vector<int> file_indices;
-  if (not options.is_set("infiles") and not options.is_set("outfiles")) {
-    std::cerr << "Need at least one of [--infiles, --outfiles]" << std::endl;
-    return EXIT_FAILURE;
-  }
-  if (options.is_set("infiles")) {
-    std::ifstream infiles{options["infiles"]};
-    if (infiles.bad() or not infiles.is_open()) {
-      std::cerr << "Could not read list of inputs: " << options["infiles"] 
-                << std::endl;
-      return EXIT_FAILURE;
-    }
-    while (not infiles.eof()) {
-      std::string tmp;
-      infiles >> tmp;
-      if (infiles.eof())
-        break;
-      infilenames.push_back(tmp);
+/**
+ * Lock-free file scheduler for --workload-split=separate. Every worker
+ * owns a contiguous range of the work list and takes items from its
+ * front. A worker whose range runs empty steals the back half of
+ * another worker's range, so nobody idles while files are left.
+ */
+struct WorkQueue {
+  WorkQueue(const std::vector<int>& items, size_t num_workers)
+    : m_items{items},
+      m_ranges{new Range[num_workers]},
+      m_num_workers{num_workers}
+  {
+    if (items.size() >= (1ull << 32))
+      throw std::length_error("WorkQueue: too many items");
+    for (size_t i = 0; i < num_workers; ++i) {
+      m_ranges[i].bounds.store(Pack(items.size() * i / num_workers,
+                                    items.size() * (i+1) / num_workers));
+      m_ranges[i].stolen.store(0);
     }
+  }
 
-    std::cout << "Inputs: " << options["infiles"] << std::endl;
-
-    if (options["mode"] == "write") {
-      std::cout << "Ignoring --infiles because --mode=write is set" 
-                << std::endl;
+  /**
+   * Get the next item for a worker (stealing if necessary)
+   *
+   * @returns FALSE IFF no work is left anywhere
+   */
+  bool Pop(size_t worker, int& item)
+  {
+    Range& own{m_ranges[worker]};
+    for (;;) {
+      uint64_t bounds{own.bounds.load(std::memory_order_acquire)};
+      const uint32_t begin{static_cast<uint32_t>(bounds >> 32)};
+      const uint32_t end{static_cast<uint32_t>(bounds)};
+      if (begin < end) {
+        if (own.bounds.compare_exchange_weak(bounds, Pack(begin+1, end),
+                                             std::memory_order_acq_rel)) {
+          item = m_items[begin];
+          return true;
+        }
+        continue;
+      }
+      if (not Steal(worker))
+        return false;
     }
   }
-  if (options.is_set("outfiles")) {
-    std::ifstream outfiles{options["outfiles"]};
-    if (outfiles.bad() or not outfiles.is_open()) {
-      std::cerr << "Could not read list of outputs: " << options["outfiles"] 
-                << std::endl;
-      return EXIT_FAILURE;
-    }
-    while (not outfiles.eof()) {
-      std::string tmp;
-      outfiles >> tmp;
-      if (outfiles.eof())
-        break;
-      outfilenames.push_back(tmp);
-    }
 
-    std::cout << "Outputs: " << options["outfiles"] << std::endl;
+  /// Total number of items which were stolen by idle workers
+  size_t getStolenCount() const
+  {
+    size_t stolen{0};
+    for (size_t i = 0; i < m_num_workers; ++i)
+      stolen += m_ranges[i].stolen.load(std::memory_order_relaxed);
+    return stolen;
+  }
 
-    if (options["mode"] == "read") {
-      std::cout << "Ignoring --outfiles because --mode=read is set" 
-                << std::endl;
+  size_t size() const
+  {
+    return m_items.size();
+  }
+
+ private:
+  /// Move the back half of another worker's range into our own (empty)
+  /// range; returns FALSE IFF all other ranges are empty
+  bool Steal(size_t thief)
+  {
+    for (size_t k = 1; k < m_num_workers; ++k) {
+      Range& victim{m_ranges[(thief + k) % m_num_workers]};
+      uint64_t bounds{victim.bounds.load(std::memory_order_acquire)};
+      for (;;) {
+        const uint32_t begin{static_cast<uint32_t>(bounds >> 32)};
+        const uint32_t end{static_cast<uint32_t>(bounds)};
+        if (begin >= end)
+          break;
+        /// The victim is busy with its current item, so even a single
+        /// remaining item is worth taking
+        const uint32_t steal{(end - begin + 1) / 2};
+        if (victim.bounds.compare_exchange_weak(bounds,
+                                                Pack(begin, end - steal),
+                                                std::memory_order_acq_rel)) {
+          Range& own{m_ranges[thief]};
+          own.bounds.store(Pack(end - steal, end), std::memory_order_release);
+          own.stolen.store(own.stolen.load(std::memory_order_relaxed) + steal,
+                           std::memory_order_relaxed);
+          return true;
+        }
+      }
     }
+    return false;
   }
-  /// Generate list of indices to files
-  for (size_t i = 0; i < std::max(infilenames.size(), 
-                                  outfilenames.size()); ++i)
-    file_indices.push_back(i);
 
+  /// [begin, end) of a range, packed into one word so that the owner
+  /// and thieves can race for it with a single CAS
+  static uint64_t Pack(uint64_t begin, uint64_t end)
+  {
+    return (begin << 32) | end;
+  }
 
-  if (options["mode"] == "read") {
-    std::cout << BOLD("READ") << " mode." << std::endl;
-  } else if (options["mode"] == "write") {
-    std::cout << BOLD("WRITE") << " mode." << std::endl;
+  struct alignas(64) Range {
+    std::atomic<uint64_t> bounds;
+    /// Items stolen BY this range's owner
+    std::atomic<size_t> stolen;
+  };
+
+  std::vector<int> m_items;
+  std::unique_ptr<Range[]> m_ranges;
+  size_t m_num_workers;
+};
+
+
+
+/**
+ * A parallelizable data-reader
+ */
+struct Worker {
+  Worker(const std::vector<int>& indices) 
+    : m_indices{indices},
+      m_next_index{0},
+      m_work_queue{nullptr},
+      m_work_queue_slot{0},
+      m_status{WorkerStatus_t::INIT},
+      m_workmode{WorkMode_t::ONLY_READ},
+      m_done{0},
+      m_first_block{0},
+      m_block_count{0},
+      m_seed{0},
+      m_skewed{false},
+      m_read_bytes{0},
+      m_written_bytes{0},
+      m_rate{0},
+      m_minor_faults{0},
+      m_major_faults{0},
+      m_page_sink{0},
+      m_verified_bytes{0},
+      m_verify_errors{0},
+      m_verify_nanoseconds{0},
+      m_worker_ID{s_running_workers_ID++}
+  {
+    for (size_t i = 0; i < NUM_OPERATIONS; ++i)
+      m_latencies.push_back(std::make_unique<LatencyHistogram::Histogram>());
+  }
+
+  Worker(Worker&& rhs)
+  {
+    m_indices          = std::move(rhs.m_indices);
+    m_next_index       = rhs.m_next_index;
+    m_work_queue       = rhs.m_work_queue;
+    m_work_queue_slot  = rhs.m_work_queue_slot;
+    m_status           = rhs.m_status;
+    m_done             = rhs.m_done;
+    m_first_block      = rhs.m_first_block;
+    m_block_count      = rhs.m_block_count;
+    m_seed             = rhs.m_seed;
+    m_skewed           = rhs.m_skewed;
+    m_RNG              = rhs.m_RNG;
+    m_read_bytes       = rhs.m_read_bytes;
+    m_written_bytes    = rhs.m_written_bytes;
+    m_latencies        = std::move(rhs.m_latencies);
+    m_rate             = rhs.m_rate;
+    m_minor_faults     = rhs.m_minor_faults;
+    m_major_faults     = rhs.m_major_faults;
+    m_page_sink        = rhs.m_page_sink;
+    m_verified_bytes   = rhs.m_verified_bytes;
+    m_verify_errors    = rhs.m_verify_errors;
+    m_verify_nanoseconds = rhs.m_verify_nanoseconds;
+    m_worker_ID        = rhs.m_worker_ID;
+  }
+
+  void Start()
+  {
+    if (m_status == WorkerStatus_t::RUNNING)
+      return;
+    m_status = WorkerStatus_t::RUNNING;
+    m_thread_ptr = std::make_unique<std::thread>(&Worker::Loop, this);
+  }
+
+  void Stop() 
+  {
+    m_status = WorkerStatus_t::STOPPING;
+    if (m_thread_ptr and m_thread_ptr->joinable())
+      m_thread_ptr->join();
+  }
+
+  void Loop() 
+  {
+    /// Start the schedule only now, so that thread startup is not
+    /// counted as a backlog
+    if (m_rate > 0)
+      m_pacemaker = std::make_unique<Pacemaker::Pacemaker>(m_rate, true);
+
+    rusage usage_before;
+    getrusage(RUSAGE_THREAD, &usage_before);
+
+    if (m_workmode == WorkMode_t::METADATA) {
+      LoopMetadata();
+    } else if (settings.pattern != AccessPattern_t::WHOLE_FILES) {
+      LoopBlocks();
+    } else if (settings.engine == ReadEngine_t::IO_URING and
+               m_workmode == WorkMode_t::ONLY_READ) {
+      LoopIOUring();
+    } else if (settings.engine == ReadEngine_t::MMAP and
+               m_workmode == WorkMode_t::ONLY_READ) {
+      LoopMmap();
+    } else {
+      LoopSync();
+    }
+
+    rusage usage_after;
+    getrusage(RUSAGE_THREAD, &usage_after);
+    m_minor_faults = usage_after.ru_minflt - usage_before.ru_minflt;
+    m_major_faults = usage_after.ru_majflt - usage_before.ru_majflt;
+
+    m_status = WorkerStatus_t::FINISHED;
+  }
+
+  /**
+   * Read (and/or write) one file after the other using C++ streams (or
+   * plain file descriptors with --direct); there is never more than one
+   * request in flight
+   */
+  void LoopSync()
+  {
+    std::unique_ptr<AlignedBufferPool> direct_buffers;
+    if (settings.direct)
+      direct_buffers = std::make_unique<AlignedBufferPool>(
+                         1, settings.block_size, settings.direct_alignment);
+    std::unique_ptr<WritePayload> payload;
+    if (m_workmode == WorkMode_t::ONLY_WRITE)
+      payload = std::make_unique<WritePayload>(
+                  std::min(settings.block_size, settings.write_size),
+                  std::random_device{}() ^ 
+                  (static_cast<uint64_t>(m_worker_ID) << 32));
+
+    int random_index;
+    while (NextIndex(random_index)) {
+      if (m_status != WorkerStatus_t::RUNNING) {
+        m_status = WorkerStatus_t::FINISHED;
+        return;
+      }
+
+      std::string content;
+      std::ofstream ofs;
+
+      if (m_workmode == WorkMode_t::ONLY_READ or
+          m_workmode == WorkMode_t::READ_AND_WRITE) {
+        /// Open random file and read it
+        const bool opened{settings.direct
+                          ? ReadFileDirect(random_index,
+                                           direct_buffers->Data(0), content)
+                          : ReadFileIfstream(random_index, content)};
+        if (not opened) {
+          ++m_done;
+          continue;
+        }
+      }
+      if (m_workmode == WorkMode_t::ONLY_WRITE)
+        WriteFile(random_index, *payload);
+      if (m_workmode == WorkMode_t::READ_AND_WRITE) {
+        auto start{std::chrono::steady_clock::now()};
+        ofs.open(outfilenames[random_index], std::ofstream::binary);
+        LogOperation(Operation_t::OPEN, start);
+        if (ofs.bad() or not ofs.is_open()) {
+          std::cerr << "Cannot write " << outfilenames[random_index] 
+                    << std::endl;
+          continue;
+        }
+        start = WaitForTurn();
+        ofs.write(content.c_str(), content.size());
+        LogOperation(Operation_t::WRITE, start);
+        start = std::chrono::steady_clock::now();
+        ofs.close();
+        LogOperation(Operation_t::CLOSE, start);
+        /// Log data
+        m_data_throughput_logger.AddSample(content.size());
+      }
+
+      ++m_done;
+    }
+  }
+
+  /**
+   * Write --write-size bytes from "payload" to an output file, in
+   * chunks of at most --bs (each chunk counts as one write request),
+   * as set by --write-variant. Deleting the old file (CREATE) counts
+   * as part of opening it, preallocation is logged as ALLOCATE.
+   * Syncing (--sync) is logged as separate SYNC operations, except for
+   * O_DSYNC where it is part of every write.
+   *
+   * @returns FALSE IFF the file could not be written
+   */
+  bool WriteFile(int index, WritePayload& payload)
+  {
+    const char* filename{outfilenames[index]};
+    int flags{O_WRONLY | O_CREAT | O_CLOEXEC |
+              (settings.sync == Sync_t::ODSYNC ? O_DSYNC : 0)};
+    switch (settings.write_variant) {
+      case WriteVariant_t::CREATE: {
+        flags |= O_EXCL;
+        break;
+      }
+      case WriteVariant_t::OVERWRITE: {
+        break;
+      }
+      case WriteVariant_t::APPEND: {
+        flags |= O_APPEND;
+        break;
+      }
+      default: {
+        flags |= O_TRUNC;
+        break;
+      }
+    }
+    const auto open_start{std::chrono::steady_clock::now()};
+    if (settings.write_variant == WriteVariant_t::CREATE)
+      unlink(filename);
+    const int fd{open(filename, flags, 0644)};
+    /// Appended data starts at the current end of the file
+    const long int base{settings.write_variant == WriteVariant_t::APPEND
+                        and fd >= 0 ? lseek(fd, 0, SEEK_END) : 0};
+    LogOperation(Operation_t::OPEN, open_start);
+    if (fd < 0 or base < 0) {
+      std::cerr << "Cannot write " << filename << " ("
+                << std::strerror(errno) << ")" << std::endl;
+      if (fd >= 0)
+        close(fd);
+      return false;
+    }
+
+    if (settings.write_variant == WriteVariant_t::PREALLOCATE and
+        settings.write_size > 0) {
+      const auto allocate_start{std::chrono::steady_clock::now()};
+      const int result{fallocate(fd, 0, 0, settings.write_size)};
+      LogOperation(Operation_t::ALLOCATE, allocate_start);
+      if (result != 0) {
+        static std::once_flag warning;
+        std::call_once(warning, [&filename]() {
+          std::cerr << "Cannot preallocate " << filename << " ("
+                    << std::strerror(errno) << "), files will be "
+                    << "extended by the writes instead" << std::endl;
+        });
+      }
+    }
+
+    bool ok{true};
+    long int unsynced_writes{0};
+    /// Range of the previous write (for --sync=sync_file_range)
+    long int previous_position{0};
+    long int previous_length{0};
+    for (long int position = 0; position < settings.write_size; ) {
+      const size_t write_size{static_cast<size_t>(
+                                std::min<long int>(
+                                  settings.write_size - position,
+                                  payload.size()))};
+      const char* data{payload.Next(write_size)};
+      const auto start{WaitForTurn()};
+      const ssize_t written{settings.write_variant == WriteVariant_t::APPEND
+                            ? write(fd, data, write_size)
+                            : pwrite(fd, data, write_size, position)};
+      LogOperation(Operation_t::WRITE, start);
+      if (written <= 0) {
+        std::cerr << "Cannot write " << filename << " ("
+                  << (written < 0 ? std::strerror(errno) : "no progress")
+                  << ")" << std::endl;
+        ok = false;
+        break;
+      }
+      m_written_bytes += written;
+
+      if (settings.sync == Sync_t::FDATASYNC_EVERY_N and
+          ++unsynced_writes >= settings.sync_every) {
+        ok = Sync(fd, index, Sync_t::FDATASYNC_EVERY_N);
+        unsynced_writes = 0;
+      } else if (settings.sync == Sync_t::SYNC_FILE_RANGE) {
+        /// Keep one range in writeback while the next one is written
+        const auto sync_start{std::chrono::steady_clock::now()};
+        ok = (sync_file_range(fd, base + position, written,
+                              SYNC_FILE_RANGE_WRITE) == 0 and
+              (previous_length == 0 or
+               sync_file_range(fd, previous_position, previous_length,
+                               SYNC_FILE_RANGE_WAIT_BEFORE |
+                               SYNC_FILE_RANGE_WRITE |
+                               SYNC_FILE_RANGE_WAIT_AFTER) == 0));
+        LogOperation(Operation_t::SYNC, sync_start);
+        previous_position = base + position;
+        previous_length   = written;
+      }
+      position += written;
+
+      /// Log data
+      m_data_throughput_logger.AddSample(written);
+      if (not ok)
+        break;
+    }
+
+    /// Make the rest of the file durable before closing it
+    if (ok and (settings.sync == Sync_t::FSYNC_PER_FILE or
+                (settings.sync == Sync_t::FDATASYNC_EVERY_N and
+                 unsynced_writes > 0) or
+                (settings.sync == Sync_t::SYNC_FILE_RANGE and
+                 previous_length > 0)))
+      ok = Sync(fd, index, settings.sync, previous_position,
+                previous_length);
+
+    const auto close_start{std::chrono::steady_clock::now()};
+    close(fd);
+    LogOperation(Operation_t::CLOSE, close_start);
+    return ok;
+  }
+
+  /**
+   * Make written data durable, logged as a SYNC operation
+   *
+   * @param mode FSYNC_PER_FILE: fsync(); FDATASYNC_EVERY_N: fdatasync();
+   *             SYNC_FILE_RANGE: wait for the writeback of the range
+   *             [position, position+length)
+   *
+   * @returns FALSE IFF syncing failed
+   */
+  bool Sync(int fd,
+            int index,
+            Sync_t mode,
+            long int position = 0,
+            long int length = 0)
+  {
+    const auto start{std::chrono::steady_clock::now()};
+    int result{0};
+    switch (mode) {
+      case Sync_t::FSYNC_PER_FILE: {
+        result = fsync(fd);
+        break;
+      }
+      case Sync_t::FDATASYNC_EVERY_N: {
+        result = fdatasync(fd);
+        break;
+      }
+      case Sync_t::SYNC_FILE_RANGE: {
+        result = sync_file_range(fd, position, length,
+                                 SYNC_FILE_RANGE_WAIT_BEFORE |
+                                 SYNC_FILE_RANGE_WRITE |
+                                 SYNC_FILE_RANGE_WAIT_AFTER);
+        break;
+      }
+      default: {
+        break;
+      }
+    }
+    LogOperation(Operation_t::SYNC, start);
+    if (result != 0) {
+      std::cerr << "Cannot sync " << outfilenames[index] << " ("
+                << std::strerror(errno) << ")" << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * Read a file in chunks using a C++ stream
+   *
+   * @param content Receives the last chunk (for --mode=readwrite)
+   *
+   * @returns FALSE IFF the file could not be opened
+   */
+  bool ReadFileIfstream(int index, std::string& content)
+  {
+    std::ifstream ifs;
+    //std::cout << infilenames[index] << std::endl;
+    const auto open_start{std::chrono::steady_clock::now()};
+    ifs.open(infilenames[index], std::ifstream::binary);
+    LogOperation(Operation_t::OPEN, open_start);
+    if (ifs.bad() or not ifs.is_open()) {
+      std::cerr << "Cannot read" << infilenames[index] 
+                << std::endl;
+      return false;
+    }
+    ifs.seekg(0, std::ios_base::end);
+    const auto length{ifs.tellg()};
+    ifs.seekg(0, std::ios_base::beg);
+    uint64_t file_id{UNKNOWN_FILE_ID};
+    /// Read in chunks
+    long int current_position{0};
+    long int still_to_read{length};
+    while (still_to_read > 0) {
+      /// Maximum chunk size --bs
+      const long int read_size{std::min(still_to_read, settings.block_size)};
+
+      content.resize(read_size);
+      const auto start{WaitForTurn()};
+      ifs.read((char*)&(content.c_str()[0]), read_size);
+      LogRead(start, ifs.gcount());
+      if (settings.verify)
+        VerifyChunk(content.data(), ifs.gcount(), current_position, index,
+                    file_id);
+
+      current_position += read_size;
+      still_to_read -= read_size;
+
+      /// Log data
+      m_data_throughput_logger.AddSample(read_size);
+    }
+
+    //ifs.open(infilenames[index], std::ifstream::binary);
+    //if (ifs.bad() or not ifs.is_open()) {
+    //  std::cerr << "Cannot read" << infilenames[index] 
+    //            << std::endl;
+    //  continue;
+    //}
+    ///// Read entire file content
+    //content = std::string{std::istreambuf_iterator<char>(ifs),
+    //                      std::istreambuf_iterator<char>()};
+
+    const auto close_start{std::chrono::steady_clock::now()};
+    ifs.close();
+    LogOperation(Operation_t::CLOSE, close_start);
+    return true;
+  }
+
+  /**
+   * Read a file in chunks with O_DIRECT into an aligned buffer. All
+   * requests are padded to the alignment; the kernel returns a short
+   * count for the unaligned tail at the end of the file.
+   *
+   * @param content Receives the last chunk (for --mode=readwrite)
+   *
+   * @returns FALSE IFF the file could not be opened
+   */
+  bool ReadFileDirect(int index, char* buffer, std::string& content)
+  {
+    const auto open_start{std::chrono::steady_clock::now()};
+    const int fd{OpenForReading(infilenames[index])};
+    LogOperation(Operation_t::OPEN, open_start);
+    struct stat file_stat;
+    if (fd < 0 or fstat(fd, &file_stat) != 0) {
+      std::cerr << "Cannot read " << infilenames[index] << std::endl;
+      if (fd >= 0)
+        close(fd);
+      return false;
+    }
+
+    const long int unit{settings.verify
+                        ? std::max<long int>(settings.direct_alignment,
+                                             Generator::VERIFY_BLOCK)
+                        : static_cast<long int>(settings.direct_alignment)};
+    long int current_position{0};
+    uint64_t file_id{UNKNOWN_FILE_ID};
+    while (current_position < file_stat.st_size) {
+      const long int read_size{std::min(file_stat.st_size - current_position,
+                                        settings.block_size)};
+      const auto start{WaitForTurn()};
+      const ssize_t bytes_read{pread(fd, buffer,
+                                     RoundUp(read_size,
+                                             settings.direct_alignment),
+                                     current_position)};
+      /// A short read before the end of the file may stop at an
+      /// unaligned offset, where the next O_DIRECT read would fail:
+      /// keep only whole aligned units (whole blocks for --verify) and
+      /// read the rest again
+      long int bytes{bytes_read};
+      if (bytes > 0 and current_position + bytes < file_stat.st_size)
+        bytes -= bytes % unit;
+      LogRead(start, bytes);
+      if (bytes <= 0) {
+        if (bytes_read < 0)
+          std::cerr << "Cannot read " << infilenames[index] << " ("
+                    << std::strerror(errno) << ")" << std::endl;
+        else if (bytes_read > 0)
+          std::cerr << "Cannot read " << infilenames[index] << " (short "
+                    << "read of less than " << unit << " bytes)"
+                    << std::endl;
+        break;
+      }
+      if (settings.verify)
+        VerifyChunk(buffer, bytes, current_position, index, file_id);
+      current_position += bytes;
+
+      /// Log data
+      m_data_throughput_logger.AddSample(bytes);
+
+      if (m_workmode == WorkMode_t::READ_AND_WRITE)
+        content.assign(buffer, bytes);
+    }
+
+    const auto close_start{std::chrono::steady_clock::now()};
+    close(fd);
+    LogOperation(Operation_t::CLOSE, close_start);
+    return true;
+  }
+
+  /**
+   * Read files via io_uring, keeping up to "settings.iodepth" reads in
+   * flight. Each in-flight read owns one registered buffer, and each
+   * open file occupies one fixed-file slot. Throughput is logged when a
+   * read completes, not when it is submitted.
+   */
+  void LoopIOUring()
+  {
+    const unsigned depth{static_cast<unsigned>(settings.iodepth)};
+    const long int chunk_size{settings.block_size};
+
+    /// Buffers must outlive the ring (declared first, destroyed last)
+    AlignedBufferPool buffers{depth, static_cast<size_t>(chunk_size),
+                              std::max<size_t>(settings.direct_alignment,
+                                               4096)};
+    std::vector<iovec> iovecs;
+    for (const auto& buffer : buffers.m_buffers)
+      iovecs.push_back(iovec{buffer.m_data, buffer.m_size});
+    /// Submission time (scheduled time with --rate) of the read which
+    /// currently owns each buffer
+    std::vector<std::chrono::steady_clock::time_point> start_times(depth);
+    /// File offset and length of the read which currently owns each
+    /// buffer, and how much of it has arrived (short reads are resumed)
+    std::vector<long int> offsets(depth);
+    std::vector<long int> lengths(depth);
+    std::vector<long int> received(depth);
+
+    URing::Ring ring;
+    if (not ring.Init(depth)) {
+      std::cerr << "Cannot set up io_uring (" << std::strerror(errno)
+                << "), falling back to ifstream" << std::endl;
+      LoopSync();
+      return;
+    }
+    const bool fixed_buffers{ring.RegisterBuffers(iovecs)};
+    bool fixed_files{ring.RegisterFiles(std::vector<int>(depth, -1))};
+
+    /// If the fixed-file table cannot be updated, reads on that slot
+    /// would fail with EBADF; submit all further reads with plain fds
+    /// instead (reads already in flight keep their valid table entry)
+    auto DropFixedFiles = [&fixed_files](const char* action) {
+      std::cerr << "Cannot " << action << " io_uring fixed-file table ("
+                << std::strerror(errno) << "), using plain file "
+                << "descriptors" << std::endl;
+      fixed_files = false;
+    };
+
+    /// Files which are currently open; fd<0 marks a free slot
+    struct OpenFile {
+      int fd;
+      int index;
+      long int length;
+      long int submitted;
+      unsigned in_flight;
+      /// A read failed (and was reported); no more reads are submitted
+      bool failed;
+      /// For --verify
+      uint64_t file_id;
+    };
+    std::vector<OpenFile> files(depth, OpenFile{-1, -1, 0, 0, 0, false,
+                                                UNKNOWN_FILE_ID});
+    int current_slot{-1};
+    unsigned in_flight{0};
+    /// With --rate: the next read is not due yet
+    bool waiting_for_turn{false};
+
+    /// Open the next readable file into a free slot
+    auto OpenNextFile = [&]() -> int {
+      const auto free_slot{std::find_if(files.begin(), files.end(),
+                                        [](const OpenFile& f) { 
+                                          return f.fd < 0; 
+                                        })};
+      if (free_slot == files.end())
+        return -1;
+      const int slot{static_cast<int>(free_slot - files.begin())};
+
+      int index;
+      while (NextIndex(index)) {
+        const auto open_start{std::chrono::steady_clock::now()};
+        const int fd{OpenForReading(infilenames[index])};
+        LogOperation(Operation_t::OPEN, open_start);
+        struct stat file_stat;
+        if (fd < 0 or fstat(fd, &file_stat) != 0) {
+          std::cerr << "Cannot read " << infilenames[index] << std::endl;
+          if (fd >= 0)
+            close(fd);
+          ++m_done;
+          continue;
+        }
+        if (file_stat.st_size == 0) {
+          close(fd);
+          ++m_done;
+          continue;
+        }
+        if (fixed_files and not ring.UpdateFile(slot, fd))
+          DropFixedFiles("update");
+        files[slot] = OpenFile{fd, index, file_stat.st_size, 0, 0, false,
+                               UNKNOWN_FILE_ID};
+        return slot;
+      }
+      return -1;
+    };
+
+    /// Queue the part of a buffer's read which has not arrived yet
+    auto PrepareChunk = [&](int slot, unsigned buffer) {
+      io_uring_sqe* sqe{ring.GetSQE()};
+      const int fd{fixed_files ? slot : files[slot].fd};
+      char* data{buffers.Data(buffer) + received[buffer]};
+      const long int length{lengths[buffer] - received[buffer]};
+      const long int offset{offsets[buffer] + received[buffer]};
+      if (fixed_buffers)
+        URing::PrepareReadFixed(sqe, fd, data, length, offset, buffer);
+      else
+        URing::PrepareRead(sqe, fd, data, length, offset);
+      if (fixed_files)
+        sqe->flags |= IOSQE_FIXED_FILE;
+      sqe->user_data = (static_cast<uint64_t>(slot) << 32) | buffer;
+    };
+
+    auto CloseFile = [&](int slot) {
+      if (fixed_files and not ring.UpdateFile(slot, -1))
+        DropFixedFiles("clear");
+      const auto close_start{std::chrono::steady_clock::now()};
+      close(files[slot].fd);
+      LogOperation(Operation_t::CLOSE, close_start);
+      files[slot].fd = -1;
+      if (current_slot == slot)
+        current_slot = -1;
+      ++m_done;
+    };
+
+    for (;;) {
+      /// Fill up the queue (unless we are asked to stop)
+      waiting_for_turn = false;
+      while (m_status == WorkerStatus_t::RUNNING and not buffers.empty()) {
+        if (current_slot < 0 or
+            files[current_slot].submitted >= files[current_slot].length) {
+          current_slot = OpenNextFile();
+          if (current_slot < 0)
+            break;
+        }
+        OpenFile& file{files[current_slot]};
+
+        std::chrono::steady_clock::time_point start;
+        if (not TryTurn(start)) {
+          waiting_for_turn = true;
+          break;
+        }
+        const unsigned buffer{buffers.Acquire()};
+        long int read_size{std::min(file.length - file.submitted,
+                                    chunk_size)};
+        /// O_DIRECT needs an aligned length, even for the file's tail
+        if (settings.direct)
+          read_size = RoundUp(read_size, settings.direct_alignment);
+
+        start_times[buffer] = start;
+        offsets[buffer] = file.submitted;
+        lengths[buffer] = read_size;
+        received[buffer] = 0;
+        PrepareChunk(current_slot, buffer);
+
+        file.submitted += read_size;
+        ++file.in_flight;
+        ++in_flight;
+      }
+
+      if (in_flight == 0) {
+        if (not waiting_for_turn)
+          break;
+        SleepUntilTurn();
+        continue;
+      }
+
+      /// When the next read is due, stop waiting for completions
+      const int submitted{waiting_for_turn
+                          ? ring.SubmitAndWait(1, NanosecondsUntilTurn())
+                          : ring.Submit(1)};
+      if (submitted < 0) {
+        std::cerr << "io_uring submission failed ("
+                  << std::strerror(-submitted) << ")" << std::endl;
+        break;
+      }
+
+      /// Harvest completions
+      io_uring_cqe cqe;
+      while (ring.PopCQE(cqe)) {
+        const int slot{static_cast<int>(cqe.user_data >> 32)};
+        const unsigned buffer{static_cast<unsigned>(cqe.user_data)};
+        OpenFile& file{files[slot]};
+        if (cqe.res > 0)
+          received[buffer] += cqe.res;
+
+        /// A short read before the end of the file (e.g. interrupted):
+        /// read the rest into the same buffer. O_DIRECT cannot resume
+        /// at an unaligned offset, so that counts as a failed read.
+        const long int end{offsets[buffer] + received[buffer]};
+        const bool short_read{cqe.res > 0 and
+                              received[buffer] < lengths[buffer] and
+                              end < file.length};
+        const bool resumable{not settings.direct or
+                             end % settings.direct_alignment == 0};
+        if (short_read and resumable and not file.failed) {
+          PrepareChunk(slot, buffer);
+          continue;
+        }
+
+        const long int bytes{cqe.res < 0 ? cqe.res :
+                             short_read and not resumable ? -EIO
+                                                          : received[buffer]};
+        LogRead(start_times[buffer], bytes);
+        if (settings.verify and bytes > 0)
+          VerifyChunk(buffers.Data(buffer), bytes, offsets[buffer],
+                      file.index, file.file_id);
+        buffers.Release(buffer);
+        --file.in_flight;
+        --in_flight;
+
+        if (bytes < 0) {
+          /// Report once, and stop submitting reads for this file
+          if (not file.failed)
+            std::cerr << "Cannot read " << infilenames[file.index] << " ("
+                      << (cqe.res < 0 ? std::strerror(-cqe.res)
+                                      : "unaligned short read")
+                      << ")" << std::endl;
+          file.failed = true;
+          file.submitted = file.length;
+        } else {
+          /// Log data
+          m_data_throughput_logger.AddSample(bytes);
+        }
+
+        if (file.in_flight == 0 and file.submitted >= file.length)
+          CloseFile(slot);
+      }
+    }
+
+    /// Clean up after an early stop
+    for (auto& file : files)
+      if (file.fd >= 0)
+        close(file.fd);
+  }
+
+  /**
+   * Read files by mapping them (--engine=mmap). Data is faulted in by
+   * touching one byte per page, or by copying it out with
+   * --mmap-access=copy, in chunks of --bs which each count as one read.
+   */
+  void LoopMmap()
+  {
+    std::vector<char> copy_buffer(settings.mmap_copy ? settings.block_size
+                                                     : 0);
+    int index;
+    while (NextIndex(index)) {
+      if (m_status != WorkerStatus_t::RUNNING)
+        return;
+
+      const auto open_start{std::chrono::steady_clock::now()};
+      const int fd{open(infilenames[index], O_RDONLY)};
+      struct stat file_stat;
+      if (fd < 0 or fstat(fd, &file_stat) != 0) {
+        std::cerr << "Cannot read " << infilenames[index] << std::endl;
+        if (fd >= 0)
+          close(fd);
+        ++m_done;
+        continue;
+      }
+      const size_t length{static_cast<size_t>(file_stat.st_size)};
+      char* map{length > 0 ? MapForReading(fd, length) : nullptr};
+      LogOperation(Operation_t::OPEN, open_start);
+      if (map == MAP_FAILED) {
+        std::cerr << "Cannot map " << infilenames[index] << " ("
+                  << std::strerror(errno) << ")" << std::endl;
+        close(fd);
+        ++m_done;
+        continue;
+      }
+
+      uint64_t file_id{UNKNOWN_FILE_ID};
+      for (size_t position = 0; position < length; ) {
+        const size_t read_size{std::min<size_t>(length - position,
+                                                settings.block_size)};
+        const auto start{WaitForTurn()};
+        ReadMapped(map + position, read_size, copy_buffer.data());
+        LogRead(start, read_size);
+        if (settings.verify)
+          VerifyChunk(map + position, read_size, position, index, file_id);
+        position += read_size;
+
+        /// Log data
+        m_data_throughput_logger.AddSample(read_size);
+      }
+
+      const auto close_start{std::chrono::steady_clock::now()};
+      if (map)
+        munmap(map, length);
+      close(fd);
+      LogOperation(Operation_t::CLOSE, close_start);
+      ++m_done;
+    }
+  }
+
+  /**
+   * Fault in a range of a mapping, either by reading one byte of every
+   * page, or by copying everything into "copy_buffer" (--mmap-access)
+   */
+  void ReadMapped(const char* data, size_t length, char* copy_buffer)
+  {
+    if (settings.mmap_copy) {
+      std::memcpy(copy_buffer, data, length);
+      m_page_sink += copy_buffer[length-1];
+      return;
+    }
+    static const size_t page_size{static_cast<size_t>(
+                                    sysconf(_SC_PAGESIZE))};
+    unsigned char sum{0};
+    for (size_t offset = 0; offset < length; offset += page_size)
+      sum += data[offset];
+    m_page_sink += sum;
+  }
+
+  /**
+   * Metadata operations only (--mode=metadata): stat() every file, or
+   * open and close it, or open, fstat, read and close it (in reads of
+   * at most --bs). Every file counts as one FILE operation, and its
+   * system calls are logged on their own as well.
+   */
+  void LoopMetadata()
+  {
+    const bool read_files{settings.metadata_op == 
+                          MetadataOp_t::OPEN_READ_CLOSE};
+    std::vector<char> buffer(read_files ? settings.block_size : 0);
+    int index;
+    while (NextIndex(index)) {
+      if (m_status != WorkerStatus_t::RUNNING)
+        return;
+
+      const char* filename{infilenames[index]};
+      const auto start{WaitForTurn()};
+      struct stat file_stat;
+      /// Failed call, and its errno (later calls may overwrite errno)
+      const char* failed{nullptr};
+      int error{0};
+      if (settings.metadata_op == MetadataOp_t::STAT) {
+        if (stat(filename, &file_stat) != 0) {
+          failed = "stat";
+          error = errno;
+        }
+        LogOperation(Operation_t::STAT, start);
+      } else {
+        const int fd{open(filename, O_RDONLY | O_CLOEXEC)};
+        if (fd < 0) {
+          failed = "open";
+          error = errno;
+        }
+        LogOperation(Operation_t::OPEN, start);
+        if (fd >= 0 and read_files) {
+          const auto stat_start{std::chrono::steady_clock::now()};
+          if (fstat(fd, &file_stat) != 0) {
+            failed = "stat";
+            error = errno;
+          }
+          LogOperation(Operation_t::STAT, stat_start);
+          for (long int position = 0; 
+               not failed and position < file_stat.st_size; ) {
+            const auto read_start{std::chrono::steady_clock::now()};
+            const ssize_t bytes_read{read(fd, buffer.data(), buffer.size())};
+            LogRead(read_start, bytes_read);
+            if (bytes_read <= 0) {
+              if (bytes_read < 0) {
+                failed = "read";
+                error = errno;
+              }
+              break;
+            }
+            position += bytes_read;
+
+            /// Log data
+            m_data_throughput_logger.AddSample(bytes_read);
+          }
+        }
+        if (fd >= 0) {
+          const auto close_start{std::chrono::steady_clock::now()};
+          close(fd);
+          LogOperation(Operation_t::CLOSE, close_start);
+        }
+      }
+      LogOperation(Operation_t::FILE, start);
+      if (failed) {
+        std::cerr << "Cannot " << failed << " " << filename << " ("
+                  << std::strerror(error) << ")" << std::endl;
+      }
+      m_operations_throughput_logger.AddSample();
+      ++m_done;
+    }
+  }
+
+  /**
+   * Read single blocks as generated by this worker's BlockStream
+   * (--pattern). All files of the BlockSpace were opened once before
+   * the run and are shared by all workers. Each read counts as one
+   * "done" item.
+   */
+  void LoopBlocks()
+  {
+    const std::vector<int>& fds{block_space.m_fds};
+    BlockStream stream{m_first_block, m_block_count, m_seed};
+    m_block_file_ids.assign(fds.size(), UNKNOWN_FILE_ID);
+    if (settings.engine == ReadEngine_t::MMAP) {
+      ReadBlocksMmap(stream);
+    } else if (settings.engine != ReadEngine_t::IO_URING or
+               not ReadBlocksIOUring(stream, fds)) {
+      ReadBlocksSync(stream, fds);
+    }
+  }
+
+  /**
+   * Length of the actual read request for a block; O_DIRECT needs the
+   * short block at the end of a file padded to the alignment
+   */
+  static long int PaddedLength(const BlockRequest& request)
+  {
+    return (settings.direct ? RoundUp(request.length,
+                                      settings.direct_alignment)
+                            : request.length);
+  }
+
+  /// Read blocks with pread, one at a time
+  void ReadBlocksSync(BlockStream& stream, const std::vector<int>& fds)
+  {
+    AlignedBufferPool buffers{1, static_cast<size_t>(settings.block_size),
+                              std::max<size_t>(settings.direct_alignment,
+                                               4096)};
+    BlockRequest request;
+    while (m_status == WorkerStatus_t::RUNNING and stream.Next(request)) {
+      const int fd{fds[request.file]};
+      if (fd >= 0) {
+        const auto start{WaitForTurn()};
+        const ssize_t bytes_read{pread(fd, buffers.Data(0),
+                                       PaddedLength(request),
+                                       request.offset)};
+        LogRead(start, bytes_read);
+        if (bytes_read > 0) {
+          if (settings.verify)
+            VerifyChunk(buffers.Data(0), bytes_read, request.offset,
+                        block_space.m_files[request.file],
+                        m_block_file_ids[request.file]);
+          /// Log data
+          m_data_throughput_logger.AddSample(bytes_read);
+        } else if (bytes_read < 0) {
+          std::cerr << "Cannot read "
+                    << infilenames[block_space.m_files[request.file]]
+                    << " at " << request.offset << " ("
+                    << std::strerror(errno) << ")" << std::endl;
+        }
+      }
+      ++m_done;
+    }
+  }
+
+  /// Read blocks from mappings of the files (--engine=mmap)
+  void ReadBlocksMmap(BlockStream& stream)
+  {
+    const std::vector<char*>& maps{block_space.m_maps};
+    std::vector<char> copy_buffer(settings.mmap_copy ? settings.block_size
+                                                     : 0);
+    BlockRequest request;
+    while (m_status == WorkerStatus_t::RUNNING and stream.Next(request)) {
+      char* map{maps[request.file]};
+      if (map) {
+        const auto start{WaitForTurn()};
+        ReadMapped(map + request.offset, request.length, copy_buffer.data());
+        LogRead(start, request.length);
+        if (settings.verify)
+          VerifyChunk(map + request.offset, request.length, request.offset,
+                      block_space.m_files[request.file],
+                      m_block_file_ids[request.file]);
+        /// Log data
+        m_data_throughput_logger.AddSample(request.length);
+      }
+      ++m_done;
+    }
+  }
+
+  /**
+   * Read blocks via io_uring with up to "settings.iodepth" reads in
+   * flight, using registered buffers and files if possible
+   *
+   * @returns FALSE IFF io_uring is not available
+   */
+  bool ReadBlocksIOUring(BlockStream& stream, const std::vector<int>& fds)
+  {
+    const unsigned depth{static_cast<unsigned>(settings.iodepth)};
+
+    /// Buffers must outlive the ring (declared first, destroyed last)
+    AlignedBufferPool buffers{depth, static_cast<size_t>(settings.block_size),
+                              std::max<size_t>(settings.direct_alignment,
+                                               4096)};
+    std::vector<iovec> iovecs;
+    for (const auto& buffer : buffers.m_buffers)
+      iovecs.push_back(iovec{buffer.m_data, buffer.m_size});
+    /// Submission time (scheduled time with --rate) of the read which
+    /// currently owns each buffer
+    std::vector<std::chrono::steady_clock::time_point> start_times(depth);
+    /// File offset of the read which currently owns each buffer
+    std::vector<long int> offsets(depth);
+
+    URing::Ring ring;
+    if (not ring.Init(depth)) {
+      std::cerr << "Cannot set up io_uring (" << std::strerror(errno)
+                << "), falling back to pread" << std::endl;
+      return false;
+    }
+    const bool fixed_buffers{ring.RegisterBuffers(iovecs)};
+    const bool fixed_files{ring.RegisterFiles(fds)};
+
+    unsigned in_flight{0};
+    bool stream_exhausted{false};
+    /// With --rate: the next read is not due yet
+    bool waiting_for_turn{false};
+    for (;;) {
+      /// Fill up the queue (unless we are asked to stop)
+      BlockRequest request;
+      waiting_for_turn = false;
+      while (m_status == WorkerStatus_t::RUNNING and not stream_exhausted and
+             not buffers.empty()) {
+        std::chrono::steady_clock::time_point start;
+        if (not TryTurn(start)) {
+          waiting_for_turn = true;
+          break;
+        }
+        if (not stream.Next(request)) {
+          stream_exhausted = true;
+          break;
+        }
+        if (fds[request.file] < 0) {
+          ++m_done;
+          continue;
+        }
+
+        const unsigned buffer{buffers.Acquire()};
+        io_uring_sqe* sqe{ring.GetSQE()};
+        const int fd{fixed_files ? request.file : fds[request.file]};
+        if (fixed_buffers) {
+          URing::PrepareReadFixed(sqe, fd, buffers.Data(buffer),
+                                  PaddedLength(request), request.offset,
+                                  buffer);
+        } else {
+          URing::PrepareRead(sqe, fd, buffers.Data(buffer),
+                             PaddedLength(request), request.offset);
+        }
+        if (fixed_files)
+          sqe->flags |= IOSQE_FIXED_FILE;
+        sqe->user_data = (static_cast<uint64_t>(request.file) << 32) | buffer;
+        start_times[buffer] = start;
+        offsets[buffer] = request.offset;
+        ++in_flight;
+      }
+
+      if (in_flight == 0) {
+        if (not waiting_for_turn)
+          break;
+        SleepUntilTurn();
+        continue;
+      }
+
+      /// When the next read is due, stop waiting for completions
+      const int submitted{waiting_for_turn
+                          ? ring.SubmitAndWait(1, NanosecondsUntilTurn())
+                          : ring.Submit(1)};
+      if (submitted < 0) {
+        std::cerr << "io_uring submission failed ("
+                  << std::strerror(-submitted) << ")" << std::endl;
+        break;
+      }
+
+      /// Harvest completions
+      io_uring_cqe cqe;
+      while (ring.PopCQE(cqe)) {
+        const int file{static_cast<int>(cqe.user_data >> 32)};
+        const unsigned buffer{static_cast<unsigned>(cqe.user_data)};
+        LogRead(start_times[buffer], cqe.res);
+        if (settings.verify and cqe.res > 0)
+          VerifyChunk(buffers.Data(buffer), cqe.res, offsets[buffer],
+                      block_space.m_files[file], m_block_file_ids[file]);
+        buffers.Release(buffer);
+        --in_flight;
+
+        if (cqe.res < 0) {
+          std::cerr << "Cannot read "
+                    << infilenames[block_space.m_files[file]] << " ("
+                    << std::strerror(-cqe.res) << ")" << std::endl;
+        } else {
+          /// Log data
+          m_data_throughput_logger.AddSample(cqe.res);
+        }
+        ++m_done;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Open-loop pacing (--rate): take the next scheduled request slot if
+   * it is due. Slots which are missed (because earlier requests took
+   * too long) pile up and are handed out back-to-back.
+   *
+   * @param start Receives the time at which the request was SCHEDULED
+   *              to start (or "now" without --rate). Latencies are
+   *              measured from there, so that the time a request spends
+   *              waiting behind slow predecessors is not omitted.
+   *
+   * @returns FALSE IFF the next request is not due yet
+   */
+  bool TryTurn(std::chrono::steady_clock::time_point& start)
+  {
+    if (not m_pacemaker) {
+      start = std::chrono::steady_clock::now();
+      return true;
+    }
+    if (not m_pacemaker->IsDue())
+      return false;
+    start = m_pacemaker->TimeOfLastBeat();
+    return true;
+  }
+
+  /// Nanoseconds until the next request is due (0 if overdue)
+  long long NanosecondsUntilTurn()
+  {
+    return std::max<long long>(0,
+             std::chrono::duration_cast<std::chrono::nanoseconds>(
+               m_pacemaker->TimeOfNextBeat() -
+               std::chrono::steady_clock::now()).count());
+  }
+
+  /// Sleep until the next request is due, but wake up at least every
+  /// 100ms to check for a stop request
+  void SleepUntilTurn()
+  {
+    std::this_thread::sleep_until(
+      std::min(m_pacemaker->TimeOfNextBeat(),
+               std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(100)));
+  }
+
+  /**
+   * Block until the next request is due (see TryTurn())
+   *
+   * @returns The time at which the request was scheduled to start
+   */
+  std::chrono::steady_clock::time_point WaitForTurn()
+  {
+    std::chrono::steady_clock::time_point start;
+    while (not TryTurn(start)) {
+      if (m_status != WorkerStatus_t::RUNNING)
+        return std::chrono::steady_clock::now();
+      SleepUntilTurn();
+    }
+    return start;
+  }
+
+  /// Operations whose latencies are recorded
+  enum class Operation_t {
+    READ,
+    WRITE,
+    OPEN,
+    CLOSE,
+    SYNC,
+    ALLOCATE,
+    STAT,
+    /// One complete --metadata-op on one file
+    FILE,
+  };
+  static constexpr size_t NUM_OPERATIONS{8};
+
+  /**
+   * Check the block headers of a chunk of an input file (--verify). The
+   * time spent on checksums is accounted separately and is not part of
+   * the read latency.
+   *
+   * @param offset Position of the chunk in the file (a multiple of
+   *               Generator::VERIFY_BLOCK)
+   * @param index Index into "infilenames" (for reports)
+   * @param file_id The file's id as seen in its first checked block
+   *                (UNKNOWN_FILE_ID before that); all blocks of a file
+   *                must agree on it
+   */
+  void VerifyChunk(const char* data,
+                   long int length,
+                   long int offset,
+                   int index,
+                   uint64_t& file_id)
+  {
+    const auto start{std::chrono::steady_clock::now()};
+    for (long int block = 0; block < length;
+         block += Generator::VERIFY_BLOCK) {
+      Generator::BlockHeader header;
+      const char* error{Generator::CheckBlock(
+                          data + block,
+                          std::min<long int>(Generator::VERIFY_BLOCK,
+                                             length - block),
+                          offset + block, header)};
+      if (not error and length - block >= 
+                        static_cast<long int>(sizeof(header))) {
+        if (file_id == UNKNOWN_FILE_ID)
+          file_id = header.file_id;
+        else if (header.file_id != file_id)
+          error = "block from another file";
+      }
+      if (error) {
+        ++m_verify_errors;
+        ReportVerifyError(infilenames[index], offset + block, error);
+      }
+    }
+    m_verified_bytes += length;
+    m_verify_nanoseconds += 
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - start).count();
+  }
+
+  /// Print a --verify failure (only the first few of all workers)
+  static void ReportVerifyError(const char* filename,
+                                long int offset,
+                                const char* error)
+  {
+    constexpr size_t MAX_REPORTS{10};
+    static std::atomic<size_t> reports{0};
+    const size_t report{reports++};
+    if (report < MAX_REPORTS) {
+      std::cerr << RED(BOLD("Corrupt data")) << " in " << filename 
+                << " at offset " << offset << ": " << error << std::endl;
+    } else if (report == MAX_REPORTS) {
+      std::cerr << "(further corrupt blocks are not shown)" << std::endl;
+    }
+  }
+
+  /**
+   * Account for one read request
+   *
+   * @param start Time at which the request was issued
+   * @param bytes Result of the request (negative for errors)
+   */
+  void LogRead(const std::chrono::steady_clock::time_point& start,
+               long int bytes)
+  {
+    LogOperation(Operation_t::READ, start);
+    if (bytes > 0)
+      m_read_bytes += bytes;
+  }
+
+  /// Record the latency of an operation which started at "start"
+  void LogOperation(Operation_t operation,
+                    const std::chrono::steady_clock::time_point& start)
+  {
+    m_latencies[static_cast<size_t>(operation)]->Record(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+
+  /// Latency histogram of one operation type (lock-free to read)
+  const LatencyHistogram::Histogram& getLatencies(Operation_t operation) const
+  {
+    return *m_latencies[static_cast<size_t>(operation)];
+  }
+
+  /**
+   * Get the index of the next file to process, either from the shared
+   * WorkQueue, from this worker's own list, or drawn (--distribution)
+   *
+   * @returns FALSE IFF there is no work left
+   */
+  bool NextIndex(int& index)
+  {
+    if (m_skewed) {
+      if (not skewed_access.Take())
+        return false;
+      index = skewed_access.DrawFile(m_RNG);
+      return true;
+    }
+    if (m_work_queue)
+      return m_work_queue->Pop(m_work_queue_slot, index);
+    if (m_next_index >= m_indices.size())
+      return false;
+    index = m_indices[m_next_index++];
+    return true;
+  }
+
+  size_t getDoneCount() const
+  {
+    return m_done;
+  }
+
+  float getThroughput()
+  {
+    return m_data_throughput_logger.FPS(1.f);
+  }
+
+  /// Files per second (--mode=metadata)
+  float getOperationsThroughput()
+  {
+    return m_operations_throughput_logger.FPS(1.f);
+  }
+
+  size_t isDone() const
+  {
+    return (m_status == WorkerStatus_t::FINISHED);
+  }
+
+  bool isStarted() const
+  {
+    return (m_status != WorkerStatus_t::INIT);
+  }
+
+  enum class WorkerStatus_t {
+    INIT,
+    RUNNING,
+    STOPPING,
+    FINISHED,
+  };
+
+  enum class WorkMode_t {
+    ONLY_READ,
+    ONLY_WRITE,
+    READ_AND_WRITE,
+    METADATA,
+    DONT_DO_SHIT,
+  };
+
+  void setMode(WorkMode_t mode)
+  {
+    m_workmode = mode;
+  }
+
+  /**
+   * Take files from a shared WorkQueue instead of the own list
+   *
+   * @param slot This worker's range in the queue
+   */
+  void setWorkQueue(WorkQueue* queue, size_t slot)
+  {
+    m_work_queue      = queue;
+    m_work_queue_slot = slot;
+  }
+
+  /**
+   * Issue requests on a fixed schedule instead of back-to-back (--rate)
+   *
+   * @param requests_per_second This worker's target rate (0 = as fast
+   *                            as possible)
+   */
+  void setRate(double requests_per_second)
+  {
+    m_rate = requests_per_second;
+  }
+
+  /**
+   * Assign this worker's share of the BlockSpace (--pattern)
+   *
+   * @param first First block of the share
+   * @param count Number of blocks to read
+   * @param seed Seed for --pattern=rand
+   */
+  void setBlockShare(long int first, long int count, unsigned seed)
+  {
+    m_first_block = first;
+    m_block_count = count;
+    m_seed        = seed;
+  }
+
+  /**
+   * Draw files from the shared SkewedAccess (--distribution) instead of
+   * taking them from a list
+   *
+   * @param seed Seed for this worker's draws
+   */
+  void setSkewed(unsigned seed)
+  {
+    m_skewed = true;
+    m_RNG.seed(seed);
+  }
+
+  std::vector<int> m_indices;
+  size_t m_next_index;
+  WorkQueue* m_work_queue;
+  size_t m_work_queue_slot;
+  WorkerStatus_t m_status;
+  WorkMode_t m_workmode;
+  std::unique_ptr<std::thread> m_thread_ptr;
+  size_t m_done;
+
+  long int m_first_block;
+  long int m_block_count;
+  unsigned m_seed;
+
+  /// Draw files with replacement (--distribution)
+  bool m_skewed;
+  std::mt19937_64 m_RNG;
+
+  /// Total size of all read requests, and of all written data
+  size_t m_read_bytes;
+  size_t m_written_bytes;
+  /// Per-operation latency histograms in nanoseconds (one per
+  /// Operation_t)
+  std::vector<std::unique_ptr<LatencyHistogram::Histogram>> m_latencies;
+
+  Throughput::Counter m_data_throughput_logger;
+  Throughput::Counter m_operations_throughput_logger;
+
+  /// Target rate in requests per second (0 = closed loop), and the
+  /// schedule derived from it
+  double m_rate;
+  std::unique_ptr<Pacemaker::Pacemaker> m_pacemaker;
+
+  /// Page faults of this worker's thread during Loop()
+  size_t m_minor_faults;
+  size_t m_major_faults;
+  /// Sum of touched bytes, so that touching pages cannot be optimized
+  /// away (--engine=mmap)
+  unsigned char m_page_sink;
+
+  /// --verify: checked bytes, corrupt blocks, and time spent on it
+  size_t m_verified_bytes;
+  size_t m_verify_errors;
+  size_t m_verify_nanoseconds;
+  /// File ids of the BlockSpace files, as seen by this worker
+  std::vector<uint64_t> m_block_file_ids;
+  static constexpr uint64_t UNKNOWN_FILE_ID{~0ull};
+
+  int m_worker_ID;
+  static int s_running_workers_ID;
+};
+/// Initialize static field
+int Worker::s_running_workers_ID = 0;
+
+
+
+/**
+ * A simple statistics module
+ */
+struct Statistificator
+{
+  void addSample(float sample)
+  {
+    m_samples.push_back(sample);
+  }
+
+  /**
+   * Mean
+   */
+  float average() const
+  {
+    float result{0.f};
+    for (size_t i = 0; i < m_samples.size(); ++i) {
+      result += m_samples[i];
+    }
+    return result/m_samples.size();
+  }
+
+  /**
+   * Mean without 5% highest / lowest outliers
+   */
+  float robustAverage() const
+  {
+    if (m_samples.size() < 100) {
+      std::cout << "! Statistificator only has " << m_samples.size() 
+                << " samples which is not really enough for reliable results!"
+                << std::endl;
+    }
+
+    /// Sort samples
+    std::vector<float> tmp{m_samples};
+    std::sort(tmp.begin(), tmp.end());
+
+    /// Compute average, leaving out the lowest/highest 5%
+    float result{0.f};
+    size_t sample_count{0};
+    for (size_t i = 0.05*tmp.size(); i < 0.95*tmp.size(); ++i) {
+      result += tmp[i];
+      ++sample_count;
+    }
+
+    return result / sample_count;
+  }
+
+  /**
+   * Minimum
+   */
+  float min() const
+  {
+    float result{std::numeric_limits<float>::max()};
+    for (auto v : m_samples)
+      if (v < result)
+        result = v;
+    return result;
+  }
+
+  /**
+   * Minimum, but ignore the first 2 and the last value because those are often skewed by
+   * program init overhead.
+   */
+  float robustMin() const
+  {
+    if (m_samples.size() < 3) {
+      std::cerr << "Too few samples!" << std::endl;
+      return -1.f;
+    }
+
+    float result{std::numeric_limits<float>::max()};
+    for (size_t i = 2; i < m_samples.size() - 1; ++i)
+      if (m_samples[i] < result)
+        result = m_samples[i];
+    return result;
+  }
+
+  std::vector<float> m_samples;
+};
+
+
+
+/**
+ * Thread-count ramp (--ramp): measures the cumulative throughput for
+ * each number of workers, and decides when adding more workers stops
+ * paying off
+ */
+struct Ramp
+{
+  /// One point of the scaling curve
+  struct Step {
+    size_t workers;
+    /// Cumulative throughput and fastest disk read in bytes/s
+    float speed;
+    float disk_speed;
+    /// CPU usage in cores
+    float cpu_usage;
+  };
+
+  /// Throughput must grow by this factor per added worker...
+  static constexpr float MIN_GAIN{1.05f};
+  /// ...or ramping stops after this many steps without such growth
+  static constexpr size_t PATIENCE{2};
+
+  Ramp()
+    : m_samples_in_step{0},
+      m_steps_without_gain{0}
+  { }
+
+  /// Add one (once-per-second) sample for the current step
+  void addSample(float speed, float cpu_usage, float disk_speed)
+  {
+    /// The first sample after adding a worker still contains time
+    /// during which the new worker was not running
+    if (m_samples_in_step++ == 0)
+      return;
+    m_speed.addSample(speed);
+    m_cpu_usage.addSample(cpu_usage);
+    m_disk_speed.addSample(disk_speed);
+  }
+
+  /**
+   * Close the current step
+   *
+   * @param workers Number of workers that were running during the step
+   *
+   * @returns TRUE IFF adding another worker is still worth a try
+   */
+  bool finishStep(size_t workers)
+  {
+    if (m_speed.m_samples.empty())
+      return true;
+
+    const Step step{workers, m_speed.average(), m_disk_speed.average(),
+                    m_cpu_usage.average()};
+    float best_speed{0.f};
+    for (const Step& previous : m_steps)
+      best_speed = std::max(best_speed, previous.speed);
+    m_steps.push_back(step);
+
+    m_speed = Statistificator{};
+    m_cpu_usage = Statistificator{};
+    m_disk_speed = Statistificator{};
+    m_samples_in_step = 0;
+
+    /// A CPU-constrained step says nothing about the disks; more
+    /// workers are exactly what it needs
+    const bool cpu_constrained{step.cpu_usage >= 0.9f * workers};
+    if (step.speed < MIN_GAIN * best_speed and not cpu_constrained)
+      ++m_steps_without_gain;
+    else
+      m_steps_without_gain = 0;
+    return (m_steps_without_gain < PATIENCE);
+  }
+
+  /**
+   * The smallest number of workers which reaches (almost) the best
+   * measured throughput
+   */
+  size_t optimalWorkers() const
+  {
+    float best_speed{0.f};
+    for (const Step& step : m_steps)
+      best_speed = std::max(best_speed, step.speed);
+    for (const Step& step : m_steps)
+      if (step.speed * MIN_GAIN >= best_speed)
+        return step.workers;
+    return 0;
+  }
+
+  /// Print the scaling curve and the recommendation
+  void print() const
+  {
+    if (m_steps.empty()) {
+      std::cout << "! --ramp: no step was long enough to be measured; "
+                << "use a larger dataset or a shorter --ramp-interval"
+                << std::endl;
+      return;
+    }
+    const size_t optimum{optimalWorkers()};
+    std::cout << "Thread-count ramp:" << '\n'
+              << "workers\t"
+              << "speed (total)\t"
+              << "speed (per worker)\t"
+              << "CPU usage\t"
+              << "disk read" << std::endl;
+    for (const Step& step : m_steps) {
+      std::cout << std::setw(7) << step.workers << "\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << step.speed / (1024*1024) << " MB/s\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << step.speed / (1024*1024) / step.workers << " MB/s\t\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << step.cpu_usage*100 << "%\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << step.disk_speed / (1024*1024) << " MB/s";
+      if (step.speed > 1.1f * step.disk_speed)
+        std::cout << " (cached?)";
+      if (step.workers == optimum)
+        std::cout << "  <--";
+      std::cout << std::endl;
+    }
+    std::cout << "Optimal number of workers: " 
+              << RED(BOLD("--jobs " + std::to_string(optimum)))
+              << std::endl;
+  }
+
+  std::vector<Step> m_steps;
+  Statistificator m_speed;
+  Statistificator m_cpu_usage;
+  Statistificator m_disk_speed;
+  size_t m_samples_in_step;
+  size_t m_steps_without_gain;
+};
+
+
+
+/**
+ * Wrap a string in a pretty gift box
+ */
+std::string Boxify(const std::string& content)
+{
+  size_t length{content.size()};
+  std::ostringstream oss;
+  oss << "╭"; for (size_t i = 0; i < length; ++i) oss << "─"; oss << "╮\n";
+  oss << "│";                oss << content;                  oss << "│\n"; 
+  oss << "╰"; for (size_t i = 0; i < length; ++i) oss << "─"; oss << "╯";
+  return oss.str();
+}
+
+
+
+/**
+ * Format a duration given in nanoseconds with a fitting unit
+ */
+std::string FormatNanoseconds(double nanoseconds)
+{
+  std::ostringstream oss;
+  oss << std::fixed;
+  if (nanoseconds < 1e3) {
+    oss << std::setprecision(0) << nanoseconds << " ns";
+  } else if (nanoseconds < 1e6) {
+    oss << std::setprecision(1) << nanoseconds/1e3 << " us";
+  } else if (nanoseconds < 1e9) {
+    oss << std::setprecision(2) << nanoseconds/1e6 << " ms";
+  } else {
+    oss << std::setprecision(2) << nanoseconds/1e9 << " s";
+  }
+  return oss.str();
+}
+
+
+/**
+ * Print percentiles of all operations which have recorded latencies
+ *
+ * @param latencies One histogram per Worker::Operation_t
+ */
+void PrintLatencies(const std::vector<LatencyHistogram::Histogram>& latencies)
+{
+  const std::vector<std::string> names{"read", "write", "open", "close",
+                                       "sync", "alloc", "stat", "file"};
+  const std::vector<double> percentiles{50., 90., 99., 99.9};
+
+  std::cout << "Latencies:\t"
+            << "p50\t\tp90\t\tp99\t\tp99.9\t\tmax\t\t(count)"
+            << std::endl;
+  for (size_t i = 0; i < latencies.size(); ++i) {
+    if (latencies[i].Count() == 0)
+      continue;
+    std::cout << "  " << names[i] << "\t";
+    for (const double percentile : percentiles) {
+      std::cout << std::setw(10)
+                << FormatNanoseconds(latencies[i].Percentile(percentile))
+                << "\t";
+    }
+    std::cout << std::setw(10) << FormatNanoseconds(latencies[i].Max())
+              << "\t(" << latencies[i].Count() << ")" << std::endl;
+  }
+}
+
+
+/**
+ * Results of one benchmark run
+ */
+struct BenchmarkResult {
+  float seconds;
+  /// Robust average/minimum of the cumulative throughput in MB/s
+  float average_speed;
+  float min_speed;
+  /// Number of completed read requests (write requests with
+  /// --mode=write), and bytes transferred by them
+  size_t requests;
+  size_t bytes;
+  /// Mean and 99th-percentile duration of such a request in microseconds
+  float mean_latency;
+  float p99_latency;
+  /// Fraction of the input files in the page cache before the run
+  float cached_fraction;
+  /// State of the dentry/inode caches before a --mode=metadata run
+  std::string name_cache;
+  /// Number of corrupt blocks found by --verify
+  size_t verify_errors;
+};
+
+
+/**
+ * Classify a page cache residency as "cold" (< 5% cached), "warm"
+ * (> 95% cached), or "mixed"
+ */
+std::string CacheTemperature(float cached_fraction)
+{
+  if (cached_fraction < 0.05f)
+    return "cold";
+  if (cached_fraction > 0.95f)
+    return "warm";
+  return "mixed";
+}
+
+
+/// Measure how much of the input files is in the page cache
+PageCache::Residency ProbeInputsCache()
+{
+  return PageCache::Probe(infilenames, std::thread::hardware_concurrency());
+}
+
+
+/**
+ * Drop the (unused) dentries and inodes of the whole system, so that
+ * --mode=metadata starts cold; needs root
+ *
+ * @returns FALSE IFF the caches could not be dropped
+ */
+bool DropNameCaches()
+{
+  const int fd{open("/proc/sys/vm/drop_caches", O_WRONLY | O_CLOEXEC)};
+  if (fd < 0)
+    return false;
+  const bool dropped{write(fd, "2", 1) == 1};
+  close(fd);
+  return dropped;
+}
+
+
+/**
+ * Sort input files by the position of their data on disk (device, then
+ * first extent), and print how fragmented they are. Files whose
+ * position is unknown keep their list order, after all others.
+ *
+ * @param file_indices Indices into "infilenames"; sorted in place
+ */
+void OrderByPhysicalLayout(std::vector<int>& file_indices)
+{
+  Timer::Timer query_time{false};
+  Extents::Summary summary;
+  const std::vector<Extents::Layout> layouts{
+    Extents::Query(infilenames, std::thread::hardware_concurrency(),
+                   summary)};
+
+  /// How often does list order seek backwards between two files?
+  size_t steps{0};
+  size_t backward_steps{0};
+  for (size_t i = 1; i < file_indices.size(); ++i) {
+    const Extents::Layout& previous{layouts[file_indices[i-1]]};
+    const Extents::Layout& next{layouts[file_indices[i]]};
+    if (previous.located and next.located and
+        previous.device == next.device) {
+      ++steps;
+      if (next.physical < previous.physical)
+        ++backward_steps;
+    }
+  }
+
+  std::stable_sort(file_indices.begin(), file_indices.end(),
+                   [&layouts](int a, int b) {
+                     const Extents::Layout& A{layouts[a]};
+                     const Extents::Layout& B{layouts[b]};
+                     if (A.located != B.located)
+                       return A.located;
+                     if (not A.located)
+                       return false;
+                     return (A.device != B.device ? A.device < B.device
+                                                  : A.physical < B.physical);
+                   });
+
+  const size_t counted_files{summary.located_files - summary.fibmap_files};
+  std::cout << "Ordering " << summary.files << " files by physical layout ("
+            << std::setprecision(2) << std::fixed
+            << query_time.ElapsedSeconds() << " seconds):" << std::endl
+            << "  " << summary.located_files << " files located";
+  if (summary.fibmap_files > 0)
+    std::cout << " (" << summary.fibmap_files << " via FIBMAP, without "
+              << "fragment counts)";
+  std::cout << std::endl;
+  if (counted_files > 0) {
+    std::cout << "  " << summary.fragmented_files << " files ("
+              << std::setprecision(1) << std::fixed
+              << 100.f * summary.fragmented_files / counted_files
+              << "%) are fragmented; " << std::setprecision(2)
+              << static_cast<float>(summary.fragments) / counted_files
+              << " fragments per file on average, at most "
+              << summary.max_fragments << std::endl;
+  }
+  if (steps > 0) {
+    std::cout << "  In list order, " << std::setprecision(1) << std::fixed
+              << 100.f * backward_steps / steps << "% of the steps to the "
+              << "next file seek backwards on disk" << std::endl;
+  }
+  const size_t unknown{summary.files - summary.located_files -
+                       summary.failed_files};
+  if (unknown > 0)
+    std::cout << "  " << unknown << " files without known position (empty, "
+              << "inline or not yet allocated) are read last" << std::endl;
+  if (summary.failed_files > 0)
+    std::cout << "  " << RED(BOLD(std::to_string(summary.failed_files)))
+              << " files cannot be read" << std::endl;
+}
+
+
+/**
+ * Print the page cache residency of the input files
+ *
+ * @param indent Prefix for the printed line
+ */
+void PrintCacheResidency(const std::string& indent,
+                         const PageCache::Residency& residency)
+{
+  std::cout << indent << "Page cache: " << std::setprecision(1) 
+            << std::fixed << 100*residency.Fraction() << "% of "
+            << residency.total_bytes / (1024.f*1024) << " MB input data "
+            << "resident (" << CacheTemperature(residency.Fraction()) << ")";
+  if (residency.failed_files > 0)
+    std::cout << "; " << residency.failed_files << " files not probed";
+  std::cout << std::endl;
+}
+
+
+/**
+ * Run the benchmark once with the current settings: create and start
+ * the workers, print/log progress until they are done, and print some
+ * statistics
+ *
+ * @param file_indices Indices of all files to be processed
+ * @param disks_info Disk I/O monitor (for cache detection)
+ * @param LOG Detailed logfile
+ * @param DISKLOG High-frequency per-device log (--disklog), or NULLPTR
+ * @param result Receives the results
+ *
+ * @returns FALSE IFF the benchmark could not be run
+ */
+bool RunBenchmark(const std::vector<int>& file_indices,
+                  std::default_random_engine& RNG,
+                  DisksIOInfo& disks_info,
+                  std::ofstream& LOG,
+                  std::ofstream* DISKLOG,
+                  BenchmarkResult& result)
+{
+  const bool metadata{options["mode"] == "metadata"};
+  const bool skewed{settings.distribution != Distribution_t::UNIFORM};
+
+  /// For --pattern, number all blocks of all files
+  size_t num_work_items{file_indices.size()};
+  if (settings.pattern != AccessPattern_t::WHOLE_FILES) {
+    /// Files are opened once here and shared by all workers, so that
+    /// many workers on many files do not run out of descriptors
+    block_space = BlockSpace{};
+    for (const int index : file_indices) {
+      const int fd{OpenForReading(infilenames[index])};
+      struct stat file_stat;
+      if (fd < 0 or fstat(fd, &file_stat) != 0) {
+        std::cerr << "Cannot read " << infilenames[index] << " ("
+                  << std::strerror(errno) << ")" << std::endl;
+        if (fd >= 0)
+          close(fd);
+        continue;
+      }
+      const size_t files_before{block_space.m_files.size()};
+      block_space.Add(index, file_stat.st_size);
+      if (block_space.m_files.size() == files_before) {
+        close(fd);
+        continue;
+      }
+      block_space.m_fds.push_back(fd);
+      if (settings.engine == ReadEngine_t::MMAP) {
+        char* map{file_stat.st_size > 0
+                  ? MapForReading(fd, file_stat.st_size) : nullptr};
+        if (map == MAP_FAILED) {
+          std::cerr << "Cannot map " << infilenames[index] << " ("
+                    << std::strerror(errno) << ")" << std::endl;
+          map = nullptr;
+        }
+        block_space.m_maps.push_back(map);
+        block_space.m_map_lengths.push_back(file_stat.st_size);
+      }
+    }
+    num_work_items = block_space.size();
+    std::cout << "Reading " << BOLD(options["pattern"]) << " blocks of "
+              << settings.block_size << " bytes; " << block_space.size()
+              << " blocks in " << block_space.m_files.size() << " files."
+              << std::endl;
+    if (num_work_items == 0) {
+      std::cerr << "No blocks to read" << std::endl;
+      return false;
+    }
+  }
+
+  /// For --distribution, draw from all files (or BlockSpace files)
+  if (skewed) {
+    const bool blocks{settings.pattern != AccessPattern_t::WHOLE_FILES};
+    if (file_indices.empty()) {
+      std::cerr << "No files to draw from" << std::endl;
+      return false;
+    }
+    skewed_access.Setup(blocks ? block_space.m_files : file_indices, blocks);
+    if (skewed_access.m_requests > 0)
+      num_work_items = skewed_access.m_requests;
+  }
+
+  /// Create workers
+  std::unique_ptr<WorkQueue> work_queue;
+  std::vector<Worker> workers;
+  const size_t njobs{static_cast<size_t>(std::stoi(options["jobs"]))};
+  const size_t num_workers{std::min(njobs, num_work_items)};
+  if (num_workers < njobs) {
+    std::cout << "! Option --jobs=" << njobs << " was specified, but we only"
+              << " have " << num_work_items << " items to read. Falling"
+              << " back to " << num_work_items << " jobs..." << std::endl;
+  }
+  std::cout << "Spawning " << num_workers << " worker threads..." << std::endl;
+  if (skewed) {
+    /// Every worker draws on its own from the shared distribution, with
+    /// an individual seed
+    const unsigned seed{static_cast<unsigned>(RNG())};
+    for (size_t i = 0; i < num_workers; ++i) {
+      Worker worker{{}};
+      worker.setBlockShare(0, 0, seed + i);
+      worker.setSkewed(seed + i);
+      workers.push_back(std::move(worker));
+    }
+  } else if (settings.pattern != AccessPattern_t::WHOLE_FILES) {
+    /// Every worker opens all files; "separate" splits the blocks into
+    /// equal shares, "overlap"/"same" let every worker read all blocks
+    /// (with individual/identical seeds for --pattern=rand)
+    const long int total_blocks{block_space.size()};
+    const unsigned seed{static_cast<unsigned>(RNG())};
+    for (size_t i = 0; i < num_workers; ++i) {
+      long int first{0};
+      long int count{total_blocks};
+      unsigned worker_seed{seed};
+      if (options["workload-split"] == "separate") {
+        first = total_blocks * i / num_workers;
+        count = total_blocks * (i+1) / num_workers - first;
+        worker_seed = seed + i;
+      } else if (options["workload-split"] == "overlap") {
+        worker_seed = seed + i;
+      }
+      Worker worker{file_indices};
+      worker.setBlockShare(first, count, worker_seed);
+      workers.push_back(std::move(worker));
+    }
+  } else if (options["workload-split"] == "separate") {
+    /// Distribute work equally among all workers; idle workers steal
+    /// from busy ones
+    std::cout << "Workload will be equally distributed among all workers."
+              << std::endl;
+    work_queue = std::make_unique<WorkQueue>(file_indices, num_workers);
+    for (size_t i = 0; i < num_workers; ++i) {
+      Worker worker{{}};
+      worker.setWorkQueue(work_queue.get(), i);
+      workers.push_back(std::move(worker));
+    }
+  } else if (options["workload-split"] == "overlap") {
+    /// All workers use the same data, but each worker uses an individual
+    /// randomized sequence
+    std::cout << "Workload is the same for all workers, but random for each."
+              << std::endl;
+    std::vector<int> copy{file_indices};
+    std::shuffle(copy.begin(), copy.end(), RNG);
+    workers.push_back(Worker{copy});
+  } else if (options["workload-split"] == "same") {
+    /// All workers use the same data sequence
+    std::cout << "Workload is exactly the same for all workers." << std::endl;
+    for (size_t i = 0; i < num_workers; ++i) {
+      workers.push_back(Worker{file_indices});
+    }
+  } else {
+    std::cerr << "Unhandled choice for \"workload-split\"" << std::endl;
+    return false;
+  }
+
+  /// Open-loop schedule (--rate), split evenly among the workers
+  double target_rate{settings.rate_iops};
+  if (settings.rate_bytes > 0)
+    target_rate = static_cast<double>(settings.rate_bytes) /
+                  settings.block_size;
+  if (target_rate > 0) {
+    const double worker_rate{target_rate / workers.size()};
+    /// Pacemaker cannot tick slower than once every 1000 seconds
+    if (worker_rate < 0.001) {
+      std::cerr << "--rate is too low for " << workers.size()
+                << " workers" << std::endl;
+      return false;
+    }
+    /// ... nor faster than once every nanosecond
+    if (worker_rate > 1e9) {
+      std::cerr << "--rate is too high (at most 1e9 requests/s per "
+                << "worker)" << std::endl;
+      return false;
+    }
+    for (auto& w : workers)
+      w.setRate(worker_rate);
+    std::cout << std::setprecision(1) << std::fixed
+              << "Open loop: issuing " << BOLD(target_rate)
+              << " requests/s (" << worker_rate << " per worker); "
+              << "latencies include queueing behind late requests."
+              << std::endl;
+  }
+
+  /// Start cold: drop all listed files from the page cache (written
+  /// outputs are synced first, since dirty pages cannot be dropped)
+  if (settings.evict_cache) {
+    Timer::Timer eviction_time{false};
+    const size_t threads{std::thread::hardware_concurrency()};
+    PageCache::Residency evicted{PageCache::Evict(infilenames, threads,
+                                                  false)};
+    const PageCache::Residency outputs{PageCache::Evict(outfilenames, 
+                                                        threads, true)};
+    evicted.total_bytes  += outputs.total_bytes;
+    evicted.failed_files += outputs.failed_files;
+    std::cout << "Evicted " << std::setprecision(1) << std::fixed
+              << evicted.total_bytes / (1024.f*1024) << " MB from the page "
+              << "cache in " << eviction_time.ElapsedSeconds() 
+              << " seconds";
+    if (evicted.failed_files > 0)
+      std::cout << " (" << evicted.failed_files << " files failed)";
+    std::cout << std::endl;
+    /// (evicting opened every input)
+    settings.inputs_looked_up = true;
+
+    /// Outputs which are about to be overwritten should be cold, too
+    /// (files which do not exist yet are skipped)
+    if (not outfilenames.empty() and options["mode"] != "read" and
+        not metadata) {
+      const PageCache::Residency residency{PageCache::Probe(outfilenames,
+                                                            threads)};
+      if (residency.total_bytes > 0 and
+          CacheTemperature(residency.Fraction()) != "cold")
+        std::cout << "! --evict-cache could not drop all output data from "
+                  << "the page cache (" << std::setprecision(1) 
+                  << std::fixed << 100*residency.Fraction() 
+                  << "% cached)" << std::endl;
+    }
+  }
+
+  /// How warm are the dentry/inode caches? Lookups which hit them cost
+  /// no disk I/O, so metadata results mean little without knowing this
+  std::string name_cache;
+  if (metadata) {
+    if (settings.evict_cache and DropNameCaches()) {
+      name_cache = "cold";
+      settings.inputs_looked_up = false;
+    } else {
+      if (settings.evict_cache)
+        std::cout << "! --evict-cache could not drop the dentry/inode "
+                  << "caches (needs root)" << std::endl;
+      name_cache = (settings.inputs_looked_up ? "warm" : "unknown");
+    }
+    std::cout << "Dentry/inode cache: " << BOLD(name_cache);
+    if (name_cache == "warm")
+      std::cout << " (every input was looked up before this run)";
+    else if (name_cache == "unknown")
+      std::cout << " (not dropped; may be warm from earlier use; "
+                << "use --evict-cache as root for a cold run)";
+    std::cout << std::endl;
+  }
+
+  /// How warm is the page cache? (not probed in metadata mode, since
+  /// opening every input would warm the dentry/inode caches)
+  float cached_fraction{0.f};
+  if (options["mode"] != "write" and not metadata) {
+    const PageCache::Residency residency{ProbeInputsCache()};
+    PrintCacheResidency("", residency);
+    cached_fraction = residency.Fraction();
+    /// Pages which are mapped/locked by other processes, or dirty,
+    /// survive POSIX_FADV_DONTNEED
+    if (settings.evict_cache and CacheTemperature(cached_fraction) != "cold")
+      std::cout << "! --evict-cache could not drop all input data from "
+                << "the page cache" << std::endl;
+  }
+
+  disks_info.update();
+  disks_info.markRunStart();
+  if (skewed)
+    skewed_access.Start();
+
+  /// Start workers (with --ramp, only the first one for now)
+  size_t started_workers{0};
+  for (auto& w : workers) {
+    if (options["mode"] == "read") {
+      w.setMode(Worker::WorkMode_t::ONLY_READ);
+    } else if (options["mode"] == "write") {
+      w.setMode(Worker::WorkMode_t::ONLY_WRITE);
+    } else if (options["mode"] == "readwrite") {
+      w.setMode(Worker::WorkMode_t::READ_AND_WRITE);
+    } else if (options["mode"] == "metadata") {
+      w.setMode(Worker::WorkMode_t::METADATA);
+    } else {
+      std::cerr << "Unhandled choice for \"mode\"" << std::endl;
+      return false;
+    }
+
+    if (not settings.ramp or started_workers == 0) {
+      w.Start();
+      ++started_workers;
+    }
+  }
+
+
+  /**
+   * returns true IFF all workers are done
+   */
+  auto allWorkersFinished = [&workers]() -> bool {
+    return std::all_of(workers.begin(),
+                       workers.end(),
+                       [](const auto& worker) { 
+                         return worker.isDone() or not worker.isStarted(); 
+                       });
+  };
+
+
+  /// Info about CPU usage
+  CPUUsageInfo cpu_info;
+  /// Print frequency
+  Pacemaker::Pacemaker print_timer{1.f};
+  /// Sub-second disk curves (--disklog) use their own sampler, so that
+  /// they do not disturb the once-per-second rates
+  std::unique_ptr<DisksIOInfo> disk_sampler;
+  Pacemaker::Pacemaker disk_timer{settings.disk_hz};
+  if (DISKLOG)
+    disk_sampler = std::make_unique<DisksIOInfo>();
+  /// Page cache probes during the run, in the background
+  std::future<PageCache::Residency> cache_probe;
+  Timer::Timer cache_probe_time{false};
+  /// Simple data statistics
+  Statistificator read_speed_log;
+  /// Log execution time
+  Timer::Timer benchmark_time{false};
+  /// Scaling curve for --ramp
+  Ramp ramp;
+  bool ramping{settings.ramp};
+  float ramp_step_start{0.f};
+  if (ramping) {
+    std::cout << "Ramping up: adding a worker every " 
+              << settings.ramp_interval << " seconds until the throughput "
+              << "stops growing." << std::endl;
+  }
+
+  /**
+   * Print a horizontal "-----" line
+   */
+  auto PrintHline = []() {
+    for (size_t i = 0; i < 10; ++i)
+      std::cout << "────────";
+    std::cout << std::endl;
+  };
+
+  /**
+   * Print column names
+   */
+  auto PrintHeaders = []() {
+    std::cout << "Progress\t"
+              << "speed\t\t"
+              << "speed\t\t"
+              << "CPU usage\t"
+              << "CPU usage\t"
+              << std::endl;
+    std::cout << "(files done)\t"
+              << "(total)\t\t"
+              << "(per worker)\t"
+              << "(total)\t\t"
+              << "(per worker)\t"
+              << std::endl;
+  };
+
+  /// Output header
+  PrintHline();
+  PrintHeaders();
+  PrintHline();
+
+
+  while (not allWorkersFinished()) {
+
+    if (disk_sampler and disk_timer.IsDue()) {
+      disk_sampler->update();
+      disk_sampler->logActivity(*DISKLOG, benchmark_time.ElapsedSeconds());
+    }
+
+    /// Print info or sleep
+    if (print_timer.IsDue()) {
+
+      LOG << benchmark_time.ElapsedSeconds()
+          << '\t' << started_workers;
+
+      /// Get progress and throughput per worker
+      float done_sum{0.f};
+      float throughput_sum{0.f};
+      float operations_sum{0.f};
+      size_t active_workers{0};
+      for (auto& worker : workers) {
+        const size_t worker_done{worker.getDoneCount()};
+        const float worker_throughput{worker.getThroughput()};
+        LOG << '\t' << worker_done
+            << '\t' << worker_throughput;
+        
+        done_sum += worker_done;
+        throughput_sum += worker_throughput;
+        operations_sum += std::max(0.f, worker.getOperationsThroughput());
+        if (worker.isStarted() and not worker.isDone())
+          ++active_workers;
+      }
+      LOG << '\t' << done_sum
+          << '\t' << throughput_sum;
+      if (not skewed and (options["workload-split"] == "overlap" or
+                          options["workload-split"] == "same")) {
+        done_sum /= started_workers;
+      }
+      /// A skewed run ends with its request or time budget
+      const float progress{skewed
+                           ? skewed_access.Progress(
+                               done_sum, benchmark_time.ElapsedSeconds())
+                           : done_sum / num_work_items};
+
+      read_speed_log.addSample(throughput_sum);
+
+      const float cpu_usage{cpu_info.getTotalCPUUsage()};
+      LOG << '\t' << cpu_usage;
+
+      /// Bleh, ugly hack. My TextDecorator does not play well with the
+      /// iomanip things, so we have to pre-format the number.
+      std::ostringstream oss;
+      oss << std::setw(7) << std::setprecision(1) << std::fixed
+          << throughput_sum / (1024*1024);
+
+      std::cout << std::setw(7) << std::setprecision(2) << std::fixed
+                << 100*progress << "%\t"
+                << BOLD(oss.str() + " MB/s") << "\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << throughput_sum / (1024*1024) / active_workers << " MB/s\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << cpu_usage*100 << "%\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << cpu_usage*100/active_workers << "%\t" << std::endl;
+      if (metadata) {
+        std::cout << "     " << std::setprecision(0) << std::fixed
+                  << operations_sum << " files/s (" 
+                  << operations_sum / active_workers << " per worker)"
+                  << std::endl;
+      }
+
+      /// Check if benchmarking is constrained by CPU (which would be bad)
+      //if (cpu_usage >= 0.9*cpu_info.getNumberOfCPUs()) {
+      if (cpu_usage >= 0.9*active_workers) {
+        std::cout << "     " << RED(BOLD("!!!")) << " " 
+                  << "(benchmark might be CPU-constrained; use more workers!)"
+                  << std::endl;
+      }
+      /// Check if experienced read speed is higher than actual disk read
+      /// (indicates that data is fetched from some cache)
+      disks_info.update();
+      const size_t actual_disk_speed{disks_info.getBackingDisksRead()};
+      if (throughput_sum > 1.1 * actual_disk_speed) {
+        std::cout << "     " << RED(BOLD("!!!")) << " " 
+                  << "(actual disk reading is much slower ("
+                  << actual_disk_speed / (1024*1024) << "MB/s); "
+                  << "data may be cached!)"
+                  << std::endl;
+      }
+      /// Per-device load: is the disk saturated, or are we not driving
+      /// it hard enough?
+      disks_info.printActivity("     ");
+
+      /// Page cache residency, if a probe finished since the last tick
+      if (cache_probe.valid() and 
+          cache_probe.wait_for(std::chrono::seconds(0)) == 
+            std::future_status::ready) {
+        PrintCacheResidency("     ", cache_probe.get());
+      }
+      if (settings.cache_probe_interval > 0.f and not metadata and
+          not cache_probe.valid() and
+          cache_probe_time.ElapsedSeconds() >= 
+            settings.cache_probe_interval) {
+        cache_probe_time.Reset();
+        cache_probe = std::async(std::launch::async, ProbeInputsCache);
+      }
+
+      /// --ramp: measure the current number of workers, then decide
+      /// whether to add another one
+      if (ramping) {
+        if (active_workers < started_workers) {
+          /// Some worker ran out of work; later samples would be skewed
+          ramp.finishStep(started_workers);
+          ramping = false;
+          std::cout << "! --ramp: out of work after " << started_workers
+                    << " workers; use a larger dataset for a full curve"
+                    << std::endl;
+        } else {
+          ramp.addSample(throughput_sum, cpu_usage, actual_disk_speed);
+          if (benchmark_time.ElapsedSeconds() - ramp_step_start >=
+              settings.ramp_interval) {
+            ramp_step_start = benchmark_time.ElapsedSeconds();
+            if (ramp.finishStep(started_workers) and
+                started_workers < workers.size()) {
+              workers[started_workers++].Start();
+              std::cout << "     --- " << started_workers
+                        << " workers ---" << std::endl;
+            } else {
+              ramping = false;
+              std::cout << "     --- ramp finished; continuing with "
+                        << started_workers << " workers ---" << std::endl;
+            }
+          }
+        }
+      }
+
+      LOG << '\n';
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(
+                                    disk_sampler ? 1 : 10));
+    }
+  }
+
+  /// UX 101: If you have a progress indicator, make sure it shows "100%"
+  std::cout << " 100.00%" << std::endl;
+  PrintHline();
+  PrintHeaders();
+  PrintHline();
+
+  /// Print some statistics
+  std::cout << "Total execution time: " 
+            << benchmark_time.ElapsedSeconds() << " seconds"
+            << std::endl;
+  const float avg_read_speed{read_speed_log.robustAverage()/(1024*1024)};
+  std::cout << "Average cumulative reading speed: " 
+            << RED(BOLD(avg_read_speed)) << RED(BOLD(" MB/s"));
+  if (metadata)
+    std::cout << " (" << name_cache << " dentry/inode cache)";
+  else if (options["mode"] != "write")
+    std::cout << " (" << CacheTemperature(cached_fraction) << " cache)";
+  std::cout << std::endl;
+  const float min_read_speed{read_speed_log.robustMin()/(1024*1024)};
+  std::cout << "Minimum cumulative reading speed: " 
+            << RED(BOLD(min_read_speed)) << RED(BOLD(" MB/s"))
+            << std::endl;
+
+  /// Merge the workers' latency histograms (no locking needed)
+  std::vector<LatencyHistogram::Histogram> latencies(Worker::NUM_OPERATIONS);
+  for (const auto& worker : workers)
+    for (size_t i = 0; i < Worker::NUM_OPERATIONS; ++i)
+      latencies[i].Add(worker.getLatencies(
+                         static_cast<Worker::Operation_t>(i)));
+  PrintLatencies(latencies);
+
+  const auto& file_latencies{
+    latencies[static_cast<size_t>(Worker::Operation_t::FILE)]};
+  if (metadata) {
+    std::cout << std::setprecision(0) << std::fixed
+              << "Metadata operations (" << options["metadata-op"] << "): "
+              << RED(BOLD(std::to_string(static_cast<size_t>(
+                   file_latencies.Count() / 
+                   benchmark_time.ElapsedSeconds())) + " files/s"))
+              << " with " << started_workers << " workers, "
+              << name_cache << " dentry/inode cache" << std::endl;
+  }
+
+  if (settings.sync != Sync_t::NONE and settings.sync != Sync_t::ODSYNC) {
+    const auto& writes{latencies[static_cast<size_t>(
+                         Worker::Operation_t::WRITE)]};
+    const auto& syncs{latencies[static_cast<size_t>(
+                        Worker::Operation_t::SYNC)]};
+    const double write_time{writes.Mean() * writes.Count()};
+    const double sync_time{syncs.Mean() * syncs.Count()};
+    if (write_time + sync_time > 0) {
+      std::cout << std::setprecision(1) << std::fixed
+                << "Durability (--sync=" << options["sync"] << "): "
+                << 100. * sync_time / (write_time + sync_time)
+                << "% of the time spent writing went into syncing" 
+                << std::endl;
+    }
+  }
+
+  size_t minor_faults{0};
+  size_t major_faults{0};
+  for (const auto& worker : workers) {
+    minor_faults += worker.m_minor_faults;
+    major_faults += worker.m_major_faults;
+  }
+  std::cout << "Page faults: " << minor_faults << " minor, "
+            << major_faults << " major" << std::endl;
+
+  size_t verified_bytes{0};
+  size_t verify_errors{0};
+  size_t verify_nanoseconds{0};
+  for (const auto& worker : workers) {
+    verified_bytes     += worker.m_verified_bytes;
+    verify_errors      += worker.m_verify_errors;
+    verify_nanoseconds += worker.m_verify_nanoseconds;
+  }
+  if (settings.verify) {
+    const double verify_seconds{verify_nanoseconds / 1e9};
+    std::cout << std::setprecision(1) << std::fixed
+              << "Verified " << verified_bytes / (1024.f*1024) << " MB: "
+              << (verify_errors == 0 ? std::string{"no"}
+                                     : RED(BOLD(std::to_string(verify_errors))))
+              << " corrupt blocks" << std::endl;
+    std::cout << "     Checksum CPU time (CRC32C, " 
+              << Checksum::Implementation() << "): " 
+              << std::setprecision(2) << verify_seconds << " seconds ("
+              << std::setprecision(1)
+              << 100. * verify_seconds / 
+                 (benchmark_time.ElapsedSeconds() * started_workers)
+              << "% of the workers' time, "
+              << (verify_seconds > 0 ? verified_bytes / verify_seconds / 
+                                       (1024*1024)
+                                     : 0.)
+              << " MB/s per core)" << std::endl;
+  }
+
+  if (settings.ramp) {
+    ramp.print();
+    if (started_workers < workers.size() and 
+        settings.pattern != AccessPattern_t::WHOLE_FILES and
+        options["workload-split"] == "separate" and not skewed) {
+      std::cout << "! The block shares of the " 
+                << workers.size() - started_workers << " workers which "
+                << "were never started have not been read" << std::endl;
+    }
+  }
+
+  if (target_rate > 0) {
+    const size_t requests{
+      latencies[static_cast<size_t>(Worker::Operation_t::READ)].Count() +
+      latencies[static_cast<size_t>(Worker::Operation_t::WRITE)].Count()};
+    const double achieved_rate{requests / benchmark_time.ElapsedSeconds()};
+    std::cout << std::setprecision(1) << std::fixed
+              << "Open loop: " << achieved_rate << " of " << target_rate
+              << " requests/s achieved" << std::endl;
+    if (achieved_rate < 0.95 * target_rate) {
+      std::cout << "     " << RED(BOLD("!!!")) << " "
+                << "(the target rate is not sustainable; latencies grow "
+                << "with the backlog)" << std::endl;
+    }
+  }
+
+  if (disks_info.hasBackingDisks()) {
+    disks_info.update();
+    std::cout << "Disks holding the input files:" << std::endl;
+    disks_info.printRunReads();
+  }
+
+  if (work_queue) {
+    std::cout << "Work stealing: " << work_queue->getStolenCount() << " of "
+              << work_queue->size() << " files were taken over by idle "
+              << "workers" << std::endl;
+  }
+
+  /// Stop workers
+  size_t bytes{0};
+  for (auto& w : workers) {
+    w.Stop();
+    bytes += w.m_read_bytes + w.m_written_bytes;
+  }
+  /// The shared BlockSpace files are only closed once nobody reads
+  for (size_t i = 0; i < block_space.m_maps.size(); ++i)
+    if (block_space.m_maps[i])
+      munmap(block_space.m_maps[i], block_space.m_map_lengths[i]);
+  for (const int fd : block_space.m_fds)
+    close(fd);
+  block_space.m_maps.clear();
+  block_space.m_fds.clear();
+  /// The next run finds the inputs in the dentry/inode caches
+  if (options["mode"] != "write")
+    settings.inputs_looked_up = true;
+
+  const auto& request_latencies{
+    metadata ? file_latencies
+             : latencies[static_cast<size_t>(options["mode"] == "write"
+                                             ? Worker::Operation_t::WRITE
+                                             : Worker::Operation_t::READ)]};
+  result.seconds         = benchmark_time.ElapsedSeconds();
+  result.average_speed   = avg_read_speed;
+  result.min_speed       = min_read_speed;
+  result.requests        = request_latencies.Count();
+  result.bytes           = bytes;
+  result.mean_latency    = request_latencies.Mean() / 1e3;
+  result.p99_latency     = request_latencies.Percentile(99.) / 1e3;
+  result.cached_fraction = cached_fraction;
+  result.name_cache = name_cache;
+  result.verify_errors   = verify_errors;
+  return true;
+}
+
+
+
+/**
+ * "iobench generate": create a test dataset and its file list
+ *
+ * @returns The exit code
+ */
+int GenerateDataset(int argc, char* argv[])
+{
+  optparse::OptionParser parser;
+  parser.usage("iobench generate [options]");
+  parser.add_option("--dir")
+        .set_default("example-data")
+        .dest("dir")
+        .help("directory to create the files in");
+  parser.add_option("-n", "--files")
+        .type("int")
+        .set_default("100")
+        .dest("files")
+        .help("number of files");
+  parser.add_option("--size")
+        .set_default("fixed:10m")
+        .dest("size")
+        .help("file size distribution: \"fixed:SIZE\", \"uniform:MIN:MAX\" or \"lognormal:MEDIAN:SIGMA\"");
+  parser.add_option("--fanout")
+        .type("int")
+        .set_default("0")
+        .dest("fanout")
+        .help("at most this many files/subdirectories per directory (0: no subdirectories)");
+  parser.add_option("-j", "--jobs")
+        .type("int")
+        .set_default(std::to_string(std::thread::hardware_concurrency()))
+        .dest("jobs")
+        .help("number of parallel writers");
+  parser.add_option("-b", "--bs")
+        .set_default("4m")
+        .dest("bs")
+        .help("size of each write request");
+  parser.add_option("-d", "--direct")
+        .action("store_true")
+        .set_default(false)
+        .dest("direct")
+        .help("bypass the page cache by writing with O_DIRECT");
+  parser.add_option("--verify")
+        .action("store_true")
+        .set_default(false)
+        .dest("verify")
+        .help("start every 4 KiB block with a checksummed header, for \"iobench --verify\"");
+  parser.add_option("--seed")
+        .type("int")
+        .dest("seed")
+        .help("seed for sizes and contents (default: random)");
+  parser.add_option("--list")
+        .dest("list")
+        .help("where to write the list of generated files (default: DIR/test-files.txt)");
+  const optparse::Values generate_options{parser.parse_args(argc, argv)};
+  auto Option = [&generate_options](const std::string& name) {
+    return generate_options[name];
+  };
+
+  Generator::Config config;
+  config.directory = Option("dir");
+  config.fanout    = std::stoi(Option("fanout"));
+  config.threads   = std::max(1, std::stoi(Option("jobs")));
+  config.direct    = generate_options.get("direct");
+  config.verify    = generate_options.get("verify");
+  config.seed      = (generate_options.is_set("seed")
+                      ? std::stoul(Option("seed"))
+                      : std::random_device{}());
+  long int write_size;
+  if (not ParseSize(Option("bs"), write_size) or write_size <= 0 or
+      (config.direct and write_size % Generator::ALIGNMENT != 0) or
+      (config.verify and write_size % Generator::VERIFY_BLOCK != 0)) {
+    std::cerr << "Invalid --bs" << std::endl;
+    return EXIT_FAILURE;
+  }
+  config.write_size = write_size;
+  if (config.fanout == 1) {
+    std::cerr << "--fanout must be 0 or at least 2" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  /// Draw all file sizes up front (reproducible with --seed)
+  const int files{std::stoi(Option("files"))};
+  std::vector<std::string> fields;
+  {
+    std::istringstream size_spec{Option("size")};
+    std::string field;
+    while (std::getline(size_spec, field, ':'))
+      fields.push_back(field);
+  }
+  std::mt19937_64 RNG{config.seed};
+  long int first, second;
+  if (files < 1) {
+    std::cerr << "--files must be positive" << std::endl;
+    return EXIT_FAILURE;
+  } else if (fields.size() == 2 and fields[0] == "fixed" and
+             ParseSize(fields[1], first)) {
+    config.sizes.assign(files, first);
+  } else if (fields.size() == 3 and fields[0] == "uniform" and
+             ParseSize(fields[1], first) and ParseSize(fields[2], second) and
+             first <= second) {
+    std::uniform_int_distribution<long int> distribution{first, second};
+    for (int i = 0; i < files; ++i)
+      config.sizes.push_back(distribution(RNG));
+  } else if (fields.size() == 3 and fields[0] == "lognormal" and
+             ParseSize(fields[1], first) and first > 0) {
+    double sigma;
+    try {
+      sigma = std::stod(fields[2]);
+    } catch (const std::logic_error&) {
+      sigma = -1.;
+    }
+    if (sigma < 0.) {
+      std::cerr << "Invalid --size sigma" << std::endl;
+      return EXIT_FAILURE;
+    }
+    std::lognormal_distribution<double> distribution{std::log(first), sigma};
+    for (int i = 0; i < files; ++i)
+      config.sizes.push_back(std::llround(distribution(RNG)));
+  } else {
+    std::cerr << "Invalid --size (expected e.g. \"fixed:10m\", "
+              << "\"uniform:1m:100m\" or \"lognormal:10m:1.5\")" 
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const size_t total_bytes{std::accumulate(config.sizes.begin(),
+                                           config.sizes.end(), 0ul)};
+
+  std::cout << "Generating " << files << " files ("
+            << std::setprecision(1) << std::fixed
+            << total_bytes / (1024.f*1024) << " MB) in "
+            << config.directory << " with " << config.threads
+            << " writers..." << std::endl;
+
+  /// Write in the background, report progress in the foreground
+  std::vector<std::string> filenames;
+  std::atomic<size_t> written{0};
+  std::atomic<bool> done{false};
+  bool ok{false};
+  Timer::Timer generate_time{false};
+  std::thread generator{[&]() {
+    ok = Generator::Generate(config, filenames, written);
+    done = true;
+  }};
+  Pacemaker::Pacemaker print_timer{1.f};
+  while (not done) {
+    if (print_timer.IsDue()) {
+      std::cout << std::setw(7) << std::setprecision(2) << std::fixed
+                << 100.f * written.load() / total_bytes << "%\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << written.load() / generate_time.ElapsedSeconds() /
+                   (1024*1024) << " MB/s" << std::endl;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  generator.join();
+  if (not ok)
+    return EXIT_FAILURE;
+
+  std::cout << "Wrote " << total_bytes / (1024.f*1024) << " MB in "
+            << generate_time.ElapsedSeconds() << " seconds ("
+            << total_bytes / generate_time.ElapsedSeconds() / (1024*1024)
+            << " MB/s)" << std::endl;
+
+  const std::string list_filename{generate_options.is_set("list")
+                                  ? Option("list")
+                                  : config.directory + "/test-files.txt"};
+  std::ofstream list{list_filename};
+  for (const auto& filename : filenames)
+    list << filename << '\n';
+  list.close();
+  if (list.fail()) {
+    std::cerr << "Could not write file list " << list_filename << std::endl;
+    return EXIT_FAILURE;
+  }
+  std::cout << "File list: " << list_filename << std::endl;
+  return EXIT_SUCCESS;
+}
+
+
+
+int main (int argc, char* argv[])
+{
+  /// Subcommands
+  if (argc > 1 and std::string{argv[1]} == "generate")
+    return GenerateDataset(argc-1, argv+1);
+
+  std::cout << Boxify("                              "
+                      "iobench"
+                      "                              ") << std::endl;
+
+  /// Command line options
+  optparse::OptionParser parser;
+  parser.add_option("-i", "--infiles")
+        .dest("infiles")
+        .help("list of input filenames");
+  parser.add_option("--indir")
+        .dest("indir")
+        .help("use all files below this directory as inputs instead of --infiles (walked in parallel)");
+  parser.add_option("--glob")
+        .dest("glob")
+        .help("only use files from --indir whose names match this shell pattern (e.g. \"*.bin\")");
+  parser.add_option("--min-size")
+        .dest("min-size")
+        .help("only use files from --indir of at least this size (e.g. \"4k\")");
+  parser.add_option("--max-size")
+        .dest("max-size")
+        .help("only use files from --indir of at most this size (e.g. \"1g\")");
+  parser.add_option("-o", "--outfiles")
+        .dest("outfiles")
+        .help("list of output filenames");
+  parser.add_option("-j", "--jobs")
+        .type("int")
+        .set_default("1")
+        .dest("jobs")
+        .help("number of parallel workers to start");
+  parser.add_option("-s", "--workload-split")
+        .choices({"separate", "overlap", "same"})
+        .set_default("separate")
+        .dest("workload-split")
+        .help("how files are split between workers ([\"separate\"] / \"overlap\" / \"same\")");
+  parser.add_option("-r", "--randomize-files")
+        .action("store_true")
+        .set_default(false)
+        .dest("randomize")
+        .help("access listed files randomly instead of sequentially");
+  parser.add_option("--order")
+        .choices({"list", "random", "physical"})
+        .set_default("list")
+        .dest("order")
+        .help("order in which input files are accessed: as listed, shuffled (like --randomize-files), or sorted by their position on disk ([\"list\"] / \"random\" / \"physical\")");
+  parser.add_option("--distribution")
+        .set_default("uniform")
+        .dest("distribution")
+        .help("draw files (and --pattern=rand offsets) with replacement from a skewed distribution, most popular first in access order ([\"uniform\"] / \"zipf:THETA\" / \"pareto[:HOT_PCT]\" / \"hotset:HOT_PCT:PROB\")");
+  parser.add_option("--requests")
+        .type("int")
+        .set_default("0")
+        .dest("requests")
+        .help("end a --distribution run after this many requests in total (default: one per file or block)");
+  parser.add_option("--runtime")
+        .type("float")
+        .set_default("0")
+        .dest("runtime")
+        .help("end a --distribution run after this many seconds");
+  parser.add_option("-m", "--mode")
+        .choices({"read", "write", "readwrite", "metadata"})
+        .set_default("read")
+        .dest("mode")
+        .help("Benchmark mode ([\"read\"] / \"write\" / \"readwrite\" / \"metadata\")");
+  parser.add_option("--metadata-op")
+        .choices({"stat", "open-close", "open-read-close"})
+        .set_default("open-close")
+        .dest("metadata-op")
+        .help("what to do with every input file if --mode=\"metadata\" (\"stat\" / [\"open-close\"] / \"open-read-close\")");
+  parser.add_option("-w", "--write-size")
+        .set_default("1048576") /*1MiB*/
+        .dest("write-size")
+        .help("how many bytes to write per target file if --mode=\"write\" (e.g. \"64m\")");
+  parser.add_option("--write-variant")
+        .set_default("sparse")
+        .dest("write-variant")
+        .help("comma-separated list of ways to write files if --mode=\"write\", one run each ([\"sparse\"] / \"create\" / \"overwrite\" / \"preallocate\" / \"append\")");
+  parser.add_option("--sync")
+        .set_default("none")
+        .dest("sync")
+        .help("how written data is made durable if --mode=\"write\" ([\"none\"] / \"fsync-per-file\" / \"fdatasync-every-N\" / \"odsync\" / \"sync_file_range\")");
+  parser.add_option("--buffer-compress-pct")
+        .type("int")
+        .set_default("0")
+        .dest("buffer-compress-pct")
+        .help("percentage of written data which is compressible (zeros) if --mode=\"write\"");
+  parser.add_option("--dedupe-pct")
+        .type("int")
+        .set_default("0")
+        .dest("dedupe-pct")
+        .help("percentage of written 4 KiB blocks which duplicate earlier ones if --mode=\"write\"");
+  parser.add_option("-e", "--engine")
+        .choices({"ifstream", "io_uring", "mmap"})
+        .set_default("ifstream")
+        .dest("engine")
+        .help("how files are read ([\"ifstream\"] / \"io_uring\" / \"mmap\")");
+  parser.add_option("-q", "--iodepth")
+        .type("int")
+        .set_default("8")
+        .dest("iodepth")
+        .help("number of reads each worker keeps in flight if --engine=\"io_uring\"");
+  parser.add_option("--madvise")
+        .set_default("none")
+        .dest("madvise")
+        .help("comma-separated madvise() advice for --engine=\"mmap\" ([\"none\"] / \"sequential\" / \"random\" / \"willneed\" / \"hugepage\" / \"populate_read\")");
+  parser.add_option("--mmap-access")
+        .choices({"touch", "copy"})
+        .set_default("touch")
+        .dest("mmap-access")
+        .help("read one byte per page, or copy all mapped data into a buffer, for --engine=\"mmap\" ([\"touch\"] / \"copy\")");
+  parser.add_option("-p", "--pattern")
+        .choices({"file", "seq", "rand", "stride"})
+        .set_default("file")
+        .dest("pattern")
+        .help("read whole files, or single blocks (--bs) sequentially, at random offsets, or strided ([\"file\"] / \"seq\" / \"rand\" / \"stride\")");
+  parser.add_option("-b", "--bs")
+        .dest("bs")
+        .help("size of each read request (default: \"10m\" chunks of whole files, \"4k\" blocks for --pattern)");
+  parser.add_option("--bs-sweep")
+        .dest("bs-sweep")
+        .help("run once for every power-of-two block size in a range, e.g. \"4k..16m\", and print a summary table");
+  parser.add_option("--offset-range")
+        .set_default("0:")
+        .dest("offset-range")
+        .help("byte range BEGIN:END of each file used by --pattern (e.g. \"0:10g\"; empty END means end of file)");
+  parser.add_option("--stride")
+        .set_default("1m")
+        .dest("stride")
+        .help("distance between consecutive reads for --pattern=\"stride\"");
+  parser.add_option("--rate")
+        .dest("rate")
+        .help("issue requests on a fixed schedule instead of as fast as possible, in bytes/s (e.g. \"200m\") or requests/s (e.g. \"5000iops\")");
+  parser.add_option("--ramp")
+        .action("store_true")
+        .set_default(false)
+        .dest("ramp")
+        .help("start with one worker and add workers (up to --jobs) until the throughput stops growing, then report the optimal --jobs");
+  parser.add_option("--ramp-interval")
+        .type("float")
+        .set_default("5")
+        .dest("ramp-interval")
+        .help("seconds to measure each worker count for if --ramp is set");
+  parser.add_option("-d", "--direct")
+        .action("store_true")
+        .set_default(false)
+        .dest("direct")
+        .help("bypass the page cache by reading with O_DIRECT");
+  parser.add_option("--evict-cache")
+        .action("store_true")
+        .set_default(false)
+        .dest("evict-cache")
+        .help("drop all listed files from the page cache before each run (no root needed)");
+  parser.add_option("--cache-probe-interval")
+        .type("float")
+        .set_default("0")
+        .dest("cache-probe-interval")
+        .help("also measure the page cache residency of the inputs every N seconds during a run (0: only before)");
+  parser.add_option("--verify")
+        .action("store_true")
+        .set_default(false)
+        .dest("verify")
+        .help("check the block headers of data from \"iobench generate --verify\" (needs --mode=read)");
+  parser.add_option("--disklog")
+        .dest("disklog")
+        .help("log the activity of every disk at --disk-hz to this file (for sub-second disk curves)");
+  parser.add_option("--disk-hz")
+        .type("float")
+        .set_default("10")
+        .dest("disk-hz")
+        .help("sampling frequency for --disklog");
+  parser.add_option("-l", "--logfile")
+        .type("string")
+        .set_default("log.txt")
+        .dest("logfile")
+        .help("detailed logfile destination");
+  options = parser.parse_args(argc, argv);
+
+  if (options["engine"] == "io_uring") {
+    settings.engine = ReadEngine_t::IO_URING;
+    const int iodepth{std::stoi(options["iodepth"])};
+    if (iodepth < 1 or iodepth > 4096) {
+      std::cerr << "--iodepth must be in [1, 4096]" << std::endl;
+      return EXIT_FAILURE;
+    }
+    settings.iodepth = iodepth;
+  } else if (options["engine"] == "mmap") {
+    settings.engine = ReadEngine_t::MMAP;
+    settings.mmap_copy = (options["mmap-access"] == "copy");
+    const std::map<std::string, int> advice_names{
+      {"sequential", MADV_SEQUENTIAL},
+      {"random", MADV_RANDOM},
+      {"willneed", MADV_WILLNEED},
+      {"hugepage", MADV_HUGEPAGE},
+      {"populate_read", MADV_POPULATE_READ},
+    };
+    std::istringstream advice_list{options["madvise"]};
+    std::string advice;
+    while (std::getline(advice_list, advice, ',')) {
+      if (advice == "none")
+        continue;
+      const auto it{advice_names.find(advice)};
+      if (it == advice_names.end()) {
+        std::cerr << "Invalid --madvise advice: " << advice << std::endl;
+        return EXIT_FAILURE;
+      }
+      settings.madvise_advice.push_back(it->second);
+    }
+  }
+
+
+  /// Parse filenames for reading
+  std::vector<int> file_indices;
+  if (not options.is_set("infiles") and not options.is_set("indir") and
+      not options.is_set("outfiles")) {
+    std::cerr << "Need at least one of [--infiles, --indir, --outfiles]"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (options.is_set("infiles") and options.is_set("indir")) {
+    std::cerr << "--infiles and --indir are mutually exclusive" << std::endl;
+    return EXIT_FAILURE;
+  }
+  Timer::Timer list_time{false};
+  if (options.is_set("indir")) {
+    DirWalk::Filter filter;
+    filter.glob = options["glob"];
+    if ((options.is_set("min-size") and
+         not ParseSize(options["min-size"], filter.min_size)) or
+        (options.is_set("max-size") and
+         (not ParseSize(options["max-size"], filter.max_size) or
+          filter.max_size < filter.min_size))) {
+      std::cerr << "Invalid --min-size/--max-size" << std::endl;
+      return EXIT_FAILURE;
+    }
+    const size_t threads{std::thread::hardware_concurrency()};
+    DirWalk::Result walk;
+    if (not DirWalk::Walk(options["indir"], filter, threads, walk)) {
+      std::cerr << "Could not open input directory: " << options["indir"]
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+    infilenames.Assign(walk.parts);
+    settings.inputs_looked_up = filter.NeedsSize();
+
+    std::cout << "Inputs: " << options["indir"] << " (" << walk.files
+              << " files in " << walk.directories << " directories, walked "
+              << "by " << threads << " threads";
+    if (walk.errors > 0)
+      std::cout << "; " << RED(BOLD(std::to_string(walk.errors)))
+                << " entries could not be read";
+    std::cout << ")" << std::endl;
+  } else if (options.is_set("glob") or options.is_set("min-size") or
+             options.is_set("max-size")) {
+    std::cout << "Ignoring --glob/--min-size/--max-size without --indir"
+              << std::endl;
+  }
+  if (options.is_set("infiles")) {
+    if (not infilenames.Load(options["infiles"],
+                             std::thread::hardware_concurrency())) {
+      std::cerr << "Could not read list of inputs: " << options["infiles"] 
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Inputs: " << options["infiles"] << std::endl;
+
+  }
+  if (options["mode"] == "write" and not infilenames.empty()) {
+    std::cout << "Ignoring --infiles/--indir because --mode=write is set"
+              << std::endl;
+  }
+  if (options.is_set("outfiles")) {
+    if (not outfilenames.Load(options["outfiles"],
+                              std::thread::hardware_concurrency())) {
+      std::cerr << "Could not read list of outputs: " << options["outfiles"] 
+                << " (" << std::strerror(errno) << ")" << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    std::cout << "Outputs: " << options["outfiles"] << std::endl;
+
+    if (options["mode"] == "read" or options["mode"] == "metadata") {
+      std::cout << "Ignoring --outfiles because --mode=" << options["mode"]
+                << " is set" << std::endl;
+    }
+  }
+  /// Generate list of indices to files
+  for (size_t i = 0; i < std::max(infilenames.size(), 
+                                  outfilenames.size()); ++i)
+    file_indices.push_back(i);
+
+
+  if (options["mode"] == "read") {
+    std::cout << BOLD("READ") << " mode." << std::endl;
+  } else if (options["mode"] == "write") {
+    std::cout << BOLD("WRITE") << " mode." << std::endl;
   } else if (options["mode"] == "readwrite") {
     std::cout << BOLD("READ-WRITE") << " mode." << std::endl;
+  } else if (options["mode"] == "metadata") {
+    std::cout << BOLD("METADATA") << " mode (" << options["metadata-op"] 
+              << ")." << std::endl;
+    if (options["metadata-op"] == "stat")
+      settings.metadata_op = MetadataOp_t::STAT;
+    else if (options["metadata-op"] == "open-read-close")
+      settings.metadata_op = MetadataOp_t::OPEN_READ_CLOSE;
+  }
+
+
+  std::cout << "Parsed " << BOLD(file_indices.size()) << " entries in "
+            << std::setprecision(2) << std::fixed
+            << list_time.ElapsedSeconds() << " seconds ("
+            << (infilenames.MemoryBytes() + outfilenames.MemoryBytes()) /
+               (1024.f*1024) << " MB)." << std::endl;
+
+  /// Info about actual disk I/O speeds (stat()ing every input would
+  /// warm the dentry/inode caches which --mode=metadata measures)
+  DisksIOInfo disks_info;
+  if (options["mode"] == "metadata") {
+    std::cout << "Not mapping inputs to disks in metadata mode" 
+              << std::endl;
+  } else if (options["mode"] != "write") {
+    MapInputsToDisks(disks_info);
+  }
+
+  if (options.get("direct")) {
+    settings.direct = true;
+    settings.direct_alignment = std::max<size_t>(
+                                  disks_info.getLargestSectorSize(), 512);
+    std::cout << "Bypassing the page cache (O_DIRECT, "
+              << settings.direct_alignment << "-byte alignment)."
+              << std::endl;
+  }
+
+  if (settings.engine == ReadEngine_t::IO_URING) {
+    std::cout << "Reading via " << BOLD("io_uring") << " with "
+              << settings.iodepth << " reads in flight per worker."
+              << std::endl;
+    if (options["mode"] != "read") {
+      std::cout << "! --engine=io_uring only supports --mode=read; "
+                << "falling back to ifstream" << std::endl;
+    }
+  }
+  if (settings.engine == ReadEngine_t::MMAP) {
+    std::cout << "Reading via " << BOLD("mmap") << " ("
+              << (settings.mmap_copy ? "copying data" : "touching pages")
+              << ", madvise: " << options["madvise"] << ")." << std::endl;
+    if (settings.direct) {
+      std::cerr << "--engine=mmap cannot be combined with --direct" 
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (options["mode"] != "read") {
+      std::cout << "! --engine=mmap only supports --mode=read; "
+                << "falling back to ifstream" << std::endl;
+    }
   }
 
+  if (options["pattern"] != "file") {
+    if (options["pattern"] == "seq") {
+      settings.pattern = AccessPattern_t::SEQUENTIAL;
+    } else if (options["pattern"] == "rand") {
+      settings.pattern = AccessPattern_t::RANDOM;
+    } else if (options["pattern"] == "stride") {
+      settings.pattern = AccessPattern_t::STRIDED;
+    }
+    if (options["mode"] != "read") {
+      std::cerr << "--pattern=" << options["pattern"] 
+                << " requires --mode=read" << std::endl;
+      return EXIT_FAILURE;
+    }
 
-  std::cout << "Parsed " << BOLD(file_indices.size()) << " entries."
-            << std::endl;
+    settings.block_size = 4096;
 
-  auto RNG = std::default_random_engine{std::random_device{}()};
+    const std::string range{options["offset-range"]};
+    const size_t colon{range.find(':')};
+    if (not ParseSize(options["stride"], settings.stride) or
+        colon == std::string::npos or
+        not ParseSize(range.substr(0, colon), settings.range_begin) or
+        (colon+1 < range.size() and
+         not ParseSize(range.substr(colon+1), settings.range_end))) {
+      std::cerr << "Invalid --stride or --offset-range" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (settings.direct and
+        settings.range_begin % settings.direct_alignment != 0) {
+      std::cerr << "--direct needs the begin of --offset-range to be a "
+                << "multiple of " << settings.direct_alignment << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
 
-  /// Randomly shuffle the list of all filenames
-  if (options.get("randomize")) {
-    std::cout << "Randomizing filenames" << std::endl;
-    std::shuffle(file_indices.begin(), file_indices.end(), RNG);
+  if (options["distribution"] != "uniform") {
+    std::vector<std::string> fields;
+    std::istringstream distribution_spec{options["distribution"]};
+    std::string field;
+    while (std::getline(distribution_spec, field, ':'))
+      fields.push_back(field);
+    std::vector<double> values;
+    try {
+      for (size_t i = 1; i < fields.size(); ++i)
+        values.push_back(std::stod(fields[i]));
+    } catch (const std::logic_error&) {
+      values.assign(1, -1.);
+    }
+    /// (an empty --distribution= has no fields at all)
+    const std::string kind{fields.empty() ? "" : fields[0]};
+    if (kind == "zipf" and values.size() == 1 and values[0] >= 0.) {
+      settings.distribution = Distribution_t::ZIPF;
+      settings.distribution_parameter = values[0];
+    } else if (kind == "pareto" and values.size() <= 1 and
+               (values.empty() or (values[0] > 0. and values[0] < 50.))) {
+      settings.distribution = Distribution_t::PARETO;
+      settings.distribution_parameter = (values.empty() ? 20. : values[0]) /
+                                        100.;
+    } else if (kind == "hotset" and values.size() == 2 and
+               values[0] > 0. and values[0] <= 100. and
+               values[1] > 0. and values[1] <= 1.) {
+      settings.distribution = Distribution_t::HOTSET;
+      settings.distribution_parameter = values[0] / 100.;
+      settings.hot_probability = values[1];
+    } else {
+      std::cerr << "Invalid --distribution (expected e.g. \"zipf:0.99\", "
+                << "\"pareto\", \"pareto:10\" or \"hotset:10:0.9\")"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (settings.pattern == AccessPattern_t::SEQUENTIAL or
+        settings.pattern == AccessPattern_t::STRIDED) {
+      std::cerr << "--distribution needs --pattern=file or --pattern=rand"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    settings.max_requests = std::stol(options["requests"]);
+    settings.runtime = std::stof(options["runtime"]);
+    if (settings.max_requests < 0 or settings.runtime < 0.f) {
+      std::cerr << "--requests and --runtime must not be negative"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (options["workload-split"] != "separate")
+      std::cout << "Ignoring --workload-split because --distribution is "
+                << "set" << std::endl;
+  } else if (options["requests"] != "0" or options["runtime"] != "0") {
+    std::cout << "Ignoring --requests/--runtime without --distribution"
+              << std::endl;
   }
 
-  /// Create workers
-  std::vector<Worker> workers;
-  const size_t njobs{static_cast<size_t>(std::stoi(options["jobs"]))};
-  const size_t num_workers{std::min(njobs, file_indices.size())};
-  if (num_workers < njobs) {
-    std::cout << "! Option --jobs=" << njobs << " was specified, but we only"
-              << " have " << file_indices.size() << " files to read. Falling"
-              << " back to " << file_indices.size() << " jobs..." << std::endl;
+  if (options.is_set("rate")) {
+    std::string rate{options["rate"]};
+    std::transform(rate.begin(), rate.end(), rate.begin(), ::tolower);
+    if (rate.size() > 2 and rate.substr(rate.size()-2) == "/s")
+      rate.resize(rate.size()-2);
+    bool valid{false};
+    if (rate.size() > 4 and rate.substr(rate.size()-4) == "iops") {
+      try {
+        settings.rate_iops = std::stod(rate.substr(0, rate.size()-4));
+        valid = (settings.rate_iops > 0);
+      } catch (const std::logic_error&) { }
+    } else {
+      valid = (ParseSize(rate, settings.rate_bytes) and 
+               settings.rate_bytes > 0);
+    }
+    if (not valid) {
+      std::cerr << "Invalid --rate (expected e.g. \"200m\" or "
+                << "\"5000iops\")" << std::endl;
+      return EXIT_FAILURE;
+    }
   }
-  std::cout << "Spawning " << num_workers << " worker threads..." << std::endl;
-  if (options["workload-split"] == "separate") {
-    /// Distribute work equally among all workers
-    std::cout << "Workload will be equally distributed among all workers."
-              << std::endl;
-    const float slice_size{static_cast<float>(file_indices.size()) / 
-                           num_workers};
-    float current_slice_begin{0.f};
-    float current_slice_end{0.f};
-    for (size_t i = 0; i < num_workers; ++i) {
-      current_slice_begin = current_slice_end;
-      current_slice_end   = std::min(current_slice_begin + slice_size,
-                                     static_cast<float>(file_indices.size()));
-      std::vector<int> slice(file_indices.begin() + current_slice_begin,
-                             file_indices.begin() + current_slice_end);
-      workers.push_back(Worker{slice});
+
+  if (options.get("ramp")) {
+    settings.ramp = true;
+    settings.ramp_interval = std::stof(options["ramp-interval"]);
+    if (settings.ramp_interval < 2.f) {
+      std::cerr << "--ramp-interval must be at least 2 seconds" << std::endl;
+      return EXIT_FAILURE;
     }
-  } else if (options["workload-split"] == "overlap") {
-    /// All workers use the same data, but each worker uses an individual
-    /// randomized sequence
-    std::cout << "Workload is the same for all workers, but random for each."
-              << std::endl;
-    std::vector<int> copy{file_indices};
-    std::shuffle(copy.begin(), copy.end(), RNG);
-    workers.push_back(Worker{copy});
-  } else if (options["workload-split"] == "same") {
-    /// All workers use the same data sequence
-    std::cout << "Workload is exactly the same for all workers." << std::endl;
-    for (size_t i = 0; i < num_workers; ++i) {
-      workers.push_back(Worker{file_indices});
+    if (options.is_set("rate")) {
+      std::cerr << "--ramp cannot be combined with --rate" << std::endl;
+      return EXIT_FAILURE;
     }
-  } else {
-    std::cerr << "Unhandled choice for \"workload-split\"" << std::endl;
+  }
+
+  settings.cache_probe_interval = std::stof(options["cache-probe-interval"]);
+  settings.evict_cache = options.get("evict-cache");
+  settings.verify = options.get("verify");
+  settings.compress_pct = std::stoi(options["buffer-compress-pct"]);
+  settings.dedupe_pct   = std::stoi(options["dedupe-pct"]);
+  if (not ParseSize(options["write-size"], settings.write_size) or
+      settings.write_size < 0) {
+    std::cerr << "Invalid --write-size" << std::endl;
     return EXIT_FAILURE;
   }
- 
-  /// Start workers
-  for (auto& w : workers) {
-    if (options["mode"] == "read") {
-      w.setMode(Worker::WorkMode_t::ONLY_READ);
-    } else if (options["mode"] == "write") {
-      w.setMode(Worker::WorkMode_t::ONLY_WRITE);
-    } else if (options["mode"] == "readwrite") {
-      w.setMode(Worker::WorkMode_t::READ_AND_WRITE);
+  {
+    const std::string sync{options["sync"]};
+    const std::string every_prefix{"fdatasync-every-"};
+    if (sync == "none") {
+      settings.sync = Sync_t::NONE;
+    } else if (sync == "fsync-per-file") {
+      settings.sync = Sync_t::FSYNC_PER_FILE;
+    } else if (sync == "odsync") {
+      settings.sync = Sync_t::ODSYNC;
+    } else if (sync == "sync_file_range") {
+      settings.sync = Sync_t::SYNC_FILE_RANGE;
+    } else if (sync.compare(0, every_prefix.size(), every_prefix) == 0 and
+               sync.size() > every_prefix.size() and
+               sync.find_first_not_of("0123456789", every_prefix.size())
+                 == std::string::npos and
+               (settings.sync_every = std::stol(
+                  sync.substr(every_prefix.size()))) > 0) {
+      settings.sync = Sync_t::FDATASYNC_EVERY_N;
     } else {
-      std::cerr << "Unhandled choice for \"mode\"" << std::endl;
+      std::cerr << "Invalid --sync (expected \"none\", "
+                << "\"fsync-per-file\", \"fdatasync-every-N\", \"odsync\" "
+                << "or \"sync_file_range\")" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (settings.sync != Sync_t::NONE and options["mode"] != "write") {
+      std::cerr << "--sync needs --mode=write" << std::endl;
       return EXIT_FAILURE;
     }
-
-    w.Start();
+  }
+  /// Write variants (one run each)
+  std::vector<WriteVariant_t> write_variants;
+  std::vector<std::string> write_variant_names;
+  {
+    const std::map<std::string, WriteVariant_t> variants{
+      {"sparse",      WriteVariant_t::SPARSE},
+      {"create",      WriteVariant_t::CREATE},
+      {"overwrite",   WriteVariant_t::OVERWRITE},
+      {"preallocate", WriteVariant_t::PREALLOCATE},
+      {"append",      WriteVariant_t::APPEND},
+    };
+    std::istringstream list{options["write-variant"]};
+    std::string name;
+    while (std::getline(list, name, ',')) {
+      const auto variant{variants.find(name)};
+      if (variant == variants.end()) {
+        std::cerr << "Invalid --write-variant \"" << name << "\"" 
+                  << std::endl;
+        return EXIT_FAILURE;
+      }
+      write_variants.push_back(variant->second);
+      write_variant_names.push_back(name);
+    }
+    if (write_variants.empty()) {
+      std::cerr << "Invalid --write-variant" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (options["write-variant"] != "sparse" and options["mode"] != "write") {
+      std::cerr << "--write-variant needs --mode=write" << std::endl;
+      return EXIT_FAILURE;
+    }
+  }
+  if (settings.compress_pct < 0 or settings.compress_pct > 100 or
+      settings.dedupe_pct < 0 or settings.dedupe_pct > 100) {
+    std::cerr << "--buffer-compress-pct and --dedupe-pct must be in "
+              << "[0, 100]" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (settings.verify and options["mode"] != "read") {
+    std::cerr << "--verify needs --mode=read" << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (settings.verify and 
+      (settings.range_begin % Generator::VERIFY_BLOCK != 0 or
+       settings.range_end % Generator::VERIFY_BLOCK != 0)) {
+    std::cerr << "--verify needs an --offset-range aligned to "
+              << Generator::VERIFY_BLOCK << " bytes" << std::endl;
+    return EXIT_FAILURE;
   }
 
+  /// Request sizes: either one (--bs), or all powers of two in a range
+  std::vector<long int> block_sizes;
+  if (options.is_set("bs-sweep")) {
+    const std::string sweep{options["bs-sweep"]};
+    const size_t dots{sweep.find("..")};
+    long int smallest, largest;
+    if (dots == std::string::npos or
+        not ParseSize(sweep.substr(0, dots), smallest) or
+        not ParseSize(sweep.substr(dots+2), largest) or
+        smallest <= 0 or largest < smallest) {
+      std::cerr << "Invalid --bs-sweep (expected e.g. \"4k..16m\")" 
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    /// Sizes are doubled from the lower bound, so that must be a power
+    /// of two already (and so must the upper bound, to be included)
+    if ((smallest & (smallest - 1)) != 0 or (largest & (largest - 1)) != 0) {
+      std::cerr << "--bs-sweep bounds must be powers of two" << std::endl;
+      return EXIT_FAILURE;
+    }
+    for (long int size = smallest; size <= largest; size *= 2)
+      block_sizes.push_back(size);
+  } else {
+    if (options.is_set("bs") and 
+        (not ParseSize(options["bs"], settings.block_size) or 
+         settings.block_size <= 0)) {
+      std::cerr << "Invalid --bs" << std::endl;
+      return EXIT_FAILURE;
+    }
+    block_sizes.push_back(settings.block_size);
+  }
+  if (settings.verify) {
+    for (const long int size : block_sizes) {
+      if (size % Generator::VERIFY_BLOCK != 0) {
+        std::cerr << "--verify needs block sizes which are multiples of "
+                  << Generator::VERIFY_BLOCK << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  if (settings.direct) {
+    for (const long int size : block_sizes) {
+      if (size % settings.direct_alignment != 0) {
+        std::cerr << "--direct needs block sizes which are multiples of "
+                  << settings.direct_alignment << std::endl;
+        return EXIT_FAILURE;
+      }
+    }
+  }
 
-  /**
-   * returns true IFF all workers are done
-   */
-  auto allWorkersFinished = [&workers]() -> bool {
-    return std::all_of(workers.begin(),
-                       workers.end(),
-                       [](const auto& worker) { return worker.isDone(); });
-  };
-
-
-  /// Info about CPU usage
-  CPUUsageInfo cpu_info;
-  /// Info about actual disk I/O speeds
-  DisksIOInfo disks_info;
-  /// Print frequency
-  Pacemaker::Pacemaker print_timer{1.f};
-  /// Simple data statistics
-  Statistificator read_speed_log;
-  /// Log execution time
-  Timer::Timer benchmark_time{false};
-
-  /**
-   * Print a horizontal "-----" line
-   */
-  auto PrintHline = []() {
-    for (size_t i = 0; i < 10; ++i)
-      std::cout << "────────";
-    std::cout << std::endl;
-  };
-
-  /**
-   * Print column names
-   */
-  auto PrintHeaders = []() {
-    std::cout << "Progress\t"
-              << "speed\t\t"
-              << "speed\t\t"
-              << "CPU usage\t"
-              << "CPU usage\t"
-              << std::endl;
-    std::cout << "(files done)\t"
-              << "(total)\t\t"
-              << "(per worker)\t"
-              << "(total)\t\t"
-              << "(per worker)\t"
-              << std::endl;
-  };
+  auto RNG = std::default_random_engine{std::random_device{}()};
 
-  /// Output header
-  PrintHline();
-  PrintHeaders();
-  PrintHline();
+  /// Sort the inputs by their position on disk (e.g. to take seeks out
+  /// of HDD runs)
+  if (options["order"] == "physical") {
+    if (options["mode"] == "write" or infilenames.empty()) {
+      std::cerr << "--order=physical needs input files" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (options.get("randomize")) {
+      std::cerr << "--order=physical and --randomize-files are mutually "
+                << "exclusive" << std::endl;
+      return EXIT_FAILURE;
+    }
+    if (file_indices.size() > infilenames.size()) {
+      std::cerr << "--order=physical needs an input for every output"
+                << std::endl;
+      return EXIT_FAILURE;
+    }
+    OrderByPhysicalLayout(file_indices);
+    settings.inputs_looked_up = true;
+  }
 
+  /// Randomly shuffle the list of all filenames
+  if (options.get("randomize") or options["order"] == "random") {
+    std::cout << "Randomizing filenames" << std::endl;
+    std::shuffle(file_indices.begin(), file_indices.end(), RNG);
+  }
 
   /// Open logfile
   std::ofstream LOG(options["logfile"]);
@@ -762,111 +4882,102 @@ int main (int argc, char* argv[])
   }
   LOG << std::fixed;
 
+  /// Open per-device logfile
+  std::unique_ptr<std::ofstream> DISKLOG;
+  if (options.is_set("disklog")) {
+    settings.disk_hz = std::stof(options["disk-hz"]);
+    if (settings.disk_hz <= 0.f or settings.disk_hz > 1000.f) {
+      std::cerr << "--disk-hz must be in (0, 1000]" << std::endl;
+      return EXIT_FAILURE;
+    }
+    DISKLOG = std::make_unique<std::ofstream>(options["disklog"]);
+    if (DISKLOG->bad() or not DISKLOG->is_open()) {
+      std::cerr << "Could not write to disk logfile \"" 
+                << options["disklog"] << "\"!" << std::endl;
+      return EXIT_FAILURE;
+    }
+    *DISKLOG << std::fixed
+             << "# seconds\tdevice\tread_iops\tread_bytes_per_s"
+             << "\twrite_iops\twrite_bytes_per_s\tavg_request_bytes"
+             << "\tavg_queue_depth\tutilization\tin_flight\n";
+  }
 
-  while (not allWorkersFinished()) {
-
-    /// Print info or sleep
-    if (print_timer.IsDue()) {
-
-      LOG << benchmark_time.ElapsedSeconds()
-          << '\t' << num_workers;
-
-      /// Get progress and throughput per worker
-      float done_sum{0.f};
-      float throughput_sum{0.f};
-      size_t active_workers{0};
-      for (auto& worker : workers) {
-        const size_t worker_done{worker.getDoneCount()};
-        const float worker_throughput{worker.getThroughput()};
-        LOG << '\t' << worker_done
-            << '\t' << worker_throughput;
-        
-        done_sum += worker_done;
-        throughput_sum += worker_throughput;
-        if (not worker.isDone())
-          ++active_workers;
-      }
-      LOG << '\t' << done_sum
-          << '\t' << throughput_sum;
-      if (options["workload-split"] == "overlap" or
-          options["workload-split"] == "same") {
-        done_sum /= num_workers;
-      }
-
-      read_speed_log.addSample(throughput_sum);
-
-      const float cpu_usage{cpu_info.getTotalCPUUsage()};
-      LOG << '\t' << cpu_usage;
-
-      /// Bleh, ugly hack. My TextDecorator does not play well with the
-      /// iomanip things, so we have to pre-format the number.
-      std::ostringstream oss;
-      oss << std::setw(7) << std::setprecision(1) << std::fixed
-          << throughput_sum / (1024*1024);
-
-      std::cout << std::setw(7) << std::setprecision(2) << std::fixed
-                << static_cast<float>(100*done_sum)/infilenames.size() << "%\t"
-                << BOLD(oss.str() + " MB/s") << "\t"
-                << std::setw(7) << std::setprecision(1) << std::fixed
-                << throughput_sum / (1024*1024) / active_workers << " MB/s\t"
-                << std::setw(7) << std::setprecision(1) << std::fixed
-                << cpu_usage*100 << "%\t"
-                << std::setw(7) << std::setprecision(1) << std::fixed
-                << cpu_usage*100/active_workers << "%\t" << std::endl;
-
-      /// Check if benchmarking is constrained by CPU (which would be bad)
-      //if (cpu_usage >= 0.9*cpu_info.getNumberOfCPUs()) {
-      if (cpu_usage >= 0.9*active_workers) {
-        std::cout << "     " << RED(BOLD("!!!")) << " " 
-                  << "(benchmark might be CPU-constrained; use more workers!)"
-                  << std::endl;
-      }
-      /// Check if experienced read speed is higher than actual disk read
-      /// (indicates that data is fetched from some cache)
-      disks_info.update();
-      const size_t actual_disk_speed{disks_info.getFastestDiskRead()};
-      if (throughput_sum > 1.1 * actual_disk_speed) {
-        std::cout << "     " << RED(BOLD("!!!")) << " " 
-                  << "(actual disk reading is much slower ("
-                  << actual_disk_speed / (1024*1024) << "MB/s); "
-                  << "data may be cached!)"
-                  << std::endl;
+  /// One run per write variant and request size
+  std::vector<BenchmarkResult> results;
+  std::vector<std::pair<std::string, long int>> runs;
+  size_t verify_errors{0};
+  for (size_t v = 0; v < write_variants.size(); ++v) {
+    settings.write_variant = write_variants[v];
+    for (const long int block_size : block_sizes) {
+      settings.block_size = block_size;
+      std::string run_name;
+      if (write_variants.size() > 1)
+        run_name = "Write variant \"" + write_variant_names[v] + "\"";
+      if (block_sizes.size() > 1) {
+        run_name += (run_name.empty() ? "Block size " : ", block size ") +
+                    std::to_string(block_size) + " bytes";
       }
+      if (not run_name.empty())
+        std::cout << '\n' << Boxify(run_name) << std::endl;
 
-      LOG << '\n';
-    } else {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      BenchmarkResult result;
+      if (not RunBenchmark(file_indices, RNG, disks_info, LOG,
+                           DISKLOG.get(), result))
+        return EXIT_FAILURE;
+      results.push_back(result);
+      runs.emplace_back(options["mode"] == "write" ? write_variant_names[v]
+                                                   : "-",
+                        block_size);
+      verify_errors += result.verify_errors;
     }
   }
 
   if (LOG.is_open())
     LOG.close();
 
-  /// UX 101: If you have a progress indicator, make sure it shows "100%"
-  std::cout << " 100.00%" << std::endl;
-  PrintHline();
-  PrintHeaders();
-  PrintHline();
-
-  /// Print some statistics
-  std::cout << "Total execution time: " 
-            << benchmark_time.ElapsedSeconds() << " seconds"
-            << std::endl;
-  const float avg_read_speed{read_speed_log.robustAverage()/(1024*1024)};
-  std::cout << "Average cumulative reading speed: " 
-            << RED(BOLD(avg_read_speed)) << RED(BOLD(" MB/s"))
-            << std::endl;
-  const float min_read_speed{read_speed_log.robustMin()/(1024*1024)};
-  std::cout << "Minimum cumulative reading speed: " 
-            << RED(BOLD(min_read_speed)) << RED(BOLD(" MB/s"))
-            << std::endl;
-            
-                    
+  /// Summary of --bs-sweep and --write-variant
+  if (results.size() > 1) {
+    std::cout << '\n' << "Summary:" << '\n'
+              << "variant    \t"
+              << "block size\t"
+              << "speed (overall)\t"
+              << "speed (min)\t"
+              << "IOPS\t\t"
+              << "latency (avg)\t"
+              << "latency (p99)\t"
+              << "cache" << std::endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+      const BenchmarkResult& result{results[i]};
+      std::cout << std::left << std::setw(11) << runs[i].first << "\t"
+                << std::right << std::setw(10) << runs[i].second << "\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << result.bytes / result.seconds / (1024*1024)
+                << " MB/s\t"
+                << std::setw(7) << std::setprecision(1) << std::fixed
+                << result.min_speed << " MB/s\t"
+                << std::setw(9) << std::setprecision(0) << std::fixed
+                << result.requests / result.seconds << "\t"
+                << std::setw(9) << std::setprecision(1) << std::fixed
+                << result.mean_latency << " us\t"
+                << std::setw(9) << std::setprecision(1) << std::fixed
+                << result.p99_latency << " us\t"
+                << (options["mode"] == "write"
+                    ? std::string{"-"}
+                    : options["mode"] == "metadata"
+                    ? result.name_cache
+                    : CacheTemperature(result.cached_fraction))
+                << std::endl;
+    }
+    if (block_sizes.size() > 1 and not settings.direct and 
+        options["mode"] != "write") {
+      std::cout << "! Every block size reads the same files; without "
+                << "--direct, later runs may be served from the page cache"
+                << std::endl;
+    }
+  }
 
-  /// Stop workers
-  for (auto& w : workers)
-    w.Stop();
-  
+  /// Corrupt data fails the run
+  if (verify_errors > 0)
+    return EXIT_FAILURE;
   return EXIT_SUCCESS;
 }
-
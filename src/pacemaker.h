@@ -138,6 +138,22 @@ namespace Pacemaker {
      */
     void SetTargetFPS( 
           float new_target_fps=30.f);
+
+    /**
+     * Get the time point of the most recent beat. With accumulated ticks,
+     * this is the time at which the beat last fetched by IsDue() was
+     * SCHEDULED (which may be well in the past if IsDue() is late).
+     *
+     * @returns Time point of the last beat
+     */
+    TIME_POINT_T TimeOfLastBeat();
+
+    /**
+     * Get the time point at which the next beat will be due
+     *
+     * @returns Time point of the next beat
+     */
+    TIME_POINT_T TimeOfNextBeat();
     
   private:
     
@@ -270,7 +286,10 @@ namespace Pacemaker {
   void Pacemaker::SetTargetFPS(float new_target_fps)
   {
     m_target_fps = new_target_fps;
-    if (m_target_fps > 0.f)
+    /// Beats cannot be shorter than 1ns (a 0ns beat would always be due)
+    if (m_target_fps > 1e9f)
+      m_ns_per_beat = TIME_RESOLUTION_T(1);
+    else if (m_target_fps > 0.f)
       m_ns_per_beat = TIME_RESOLUTION_T((long)1e12/(long)(1e3*m_target_fps));
 
     #ifdef DEBUG_MODE
@@ -288,6 +307,34 @@ namespace Pacemaker {
       std::cout << oss.str();
     #endif
   }
+
+  /**
+   * Get the time point of the most recent beat. With accumulated ticks,
+   * this is the time at which the beat last fetched by IsDue() was
+   * SCHEDULED (which may be well in the past if IsDue() is late).
+   *
+   * @returns Time point of the last beat
+   */
+  TIME_POINT_T Pacemaker::TimeOfLastBeat()
+  {
+    #ifdef THREAD_SAFE
+      std::lock_guard<std::mutex> lock(m_IsDue__LOCK);
+    #endif
+    return m_time_of_last_beat;
+  }
+
+  /**
+   * Get the time point at which the next beat will be due
+   *
+   * @returns Time point of the next beat
+   */
+  TIME_POINT_T Pacemaker::TimeOfNextBeat()
+  {
+    #ifdef THREAD_SAFE
+      std::lock_guard<std::mutex> lock(m_IsDue__LOCK);
+    #endif
+    return m_time_of_last_beat + m_ns_per_beat;
+  }
   
 
 
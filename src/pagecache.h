@@ -0,0 +1,238 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Page cache residency probe and eviction (header-only)
+ *
+ * Maps files and asks mincore() which of their pages are in the page
+ * cache, or drops files from the cache with posix_fadvise(). Mapping a
+ * file does not read it, so probing is cheap even for huge files: large
+ * files are mapped in windows of WINDOW_BYTES, and file lists are split
+ * into chunks of CHUNK_FILES which a pool of threads takes turns on.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > std::vector<std::string> files{"a.bin", "b.bin"};
+ * > const PageCache::Residency residency{PageCache::Probe(files, 8)};
+ * > std::cout << 100*residency.Fraction() << "% cached\n";
+ * >
+ * > PageCache::Evict(files, 8, true);
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef PAGECACHE_H__
+#define PAGECACHE_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace PageCache {
+
+  /// Largest part of a file which is mapped at once
+  constexpr size_t WINDOW_BYTES = 1ul << 30;
+  /// Number of files a thread takes from the list at once
+  constexpr size_t CHUNK_FILES = 64;
+
+
+  /**
+   * How much of a set of files is in the page cache
+   */
+  struct Residency {
+    size_t resident_bytes;
+    size_t total_bytes;
+    /// Files which could not be probed (or evicted)
+    size_t failed_files;
+
+    /// Resident fraction in [0,1] (1 for empty file sets)
+    float Fraction() const
+    {
+      return (total_bytes > 0 ? static_cast<float>(resident_bytes) /
+                                total_bytes
+                              : 1.f);
+    }
+  };
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Count the resident bytes of one open file
+   *
+   * @param vector Scratch space for mincore() (reused between calls)
+   *
+   * @returns FALSE IFF the file cannot be probed
+   */
+  static bool ProbeFile(int fd,
+                        size_t length,
+                        std::vector<unsigned char>& vector,
+                        size_t& resident_bytes)
+  {
+    const size_t page_size = sysconf(_SC_PAGESIZE);
+    resident_bytes = 0;
+    for (size_t offset = 0; offset < length; offset += WINDOW_BYTES) {
+      const size_t window = std::min(WINDOW_BYTES, length - offset);
+      void* map = mmap(nullptr, window, PROT_READ, MAP_SHARED, fd, offset);
+      if (map == MAP_FAILED)
+        return false;
+      const size_t pages = (window + page_size - 1) / page_size;
+      vector.resize(pages);
+      const bool ok = (mincore(map, window, vector.data()) == 0);
+      munmap(map, window);
+      if (not ok)
+        return false;
+
+      size_t resident_pages = 0;
+      for (const unsigned char page : vector)
+        resident_pages += (page & 1);
+      /// The last page of a file may be partial
+      resident_bytes += std::min(resident_pages * page_size, window);
+    }
+    return true;
+  }
+
+  /// Filenames may come as strings or as plain C strings
+  inline const char* CString(const std::string& text)
+  {
+    return text.c_str();
+  }
+
+  inline const char* CString(const char* text)
+  {
+    return text;
+  }
+
+  /**
+   * Run "function(filename, residency)" for every file, on "threads"
+   * threads which take chunks of CHUNK_FILES files from the list
+   *
+   * @param files Any list with size() and operator[] which yields
+   *              std::string or const char*
+   *
+   * @returns The sum of all per-thread results
+   */
+  template <typename Files, typename Function>
+  static Residency ForEachFile(const Files& files,
+                               size_t threads,
+                               Function function)
+  {
+    threads = std::max<size_t>(1, std::min(threads,
+                                           (files.size() + CHUNK_FILES - 1) /
+                                           CHUNK_FILES));
+    std::atomic<size_t> next_chunk{0};
+    std::vector<Residency> results(threads, Residency{0, 0, 0});
+    std::vector<std::thread> pool;
+    for (size_t t = 0; t < threads; ++t) {
+      pool.emplace_back([&, t]() {
+        for (;;) {
+          const size_t begin = next_chunk.fetch_add(CHUNK_FILES);
+          if (begin >= files.size())
+            return;
+          const size_t end = std::min(begin + CHUNK_FILES, files.size());
+          for (size_t i = begin; i < end; ++i)
+            function(CString(files[i]), results[t]);
+        }
+      });
+    }
+    for (auto& thread : pool)
+      thread.join();
+
+    Residency total{0, 0, 0};
+    for (const auto& result : results) {
+      total.resident_bytes += result.resident_bytes;
+      total.total_bytes    += result.total_bytes;
+      total.failed_files   += result.failed_files;
+    }
+    return total;
+  }
+
+  /**
+   * Measure how much of a list of files is in the page cache
+   *
+   * @param files Filenames (see ForEachFile)
+   * @param threads Number of threads to probe with
+   *
+   * @returns Resident and total bytes of all files
+   */
+  template <typename Files>
+  static Residency Probe(const Files& files,
+                         size_t threads)
+  {
+    return ForEachFile(files, threads,
+      [](const char* filename, Residency& residency) {
+        thread_local std::vector<unsigned char> vector;
+        const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+        struct stat file_stat;
+        size_t resident_bytes;
+        if (fd < 0 or fstat(fd, &file_stat) != 0 or
+            not ProbeFile(fd, file_stat.st_size, vector, resident_bytes)) {
+          ++residency.failed_files;
+        } else {
+          residency.resident_bytes += resident_bytes;
+          residency.total_bytes    += file_stat.st_size;
+        }
+        if (fd >= 0)
+          close(fd);
+      });
+  }
+
+  /**
+   * Drop a list of files from the page cache. Dirty pages cannot be
+   * dropped, so files which may have been written should be synced
+   * first. Files which do not exist are skipped silently.
+   *
+   * @param files Filenames (see ForEachFile)
+   * @param threads Number of threads to evict with
+   * @param sync_first Write back dirty pages with fdatasync() first
+   *
+   * @returns The total size of the evicted files in "total_bytes"
+   */
+  template <typename Files>
+  static Residency Evict(const Files& files,
+                         size_t threads,
+                         bool sync_first)
+  {
+    return ForEachFile(files, threads,
+      [sync_first](const char* filename, Residency& residency) {
+        const int fd = open(filename, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+          if (errno != ENOENT)
+            ++residency.failed_files;
+          return;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 or
+            (sync_first and fdatasync(fd) != 0) or
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) != 0) {
+          ++residency.failed_files;
+        } else {
+          residency.total_bytes += file_stat.st_size;
+        }
+        close(fd);
+      });
+  }
+
+
+}  // namespace PageCache
+
+
+#endif  // PAGECACHE_H__
+
@@ -0,0 +1,231 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Lock-free throughput counter for one writer thread (header-only)
+ *
+ * Successor of the old FramesPerSecond::FPSEstimator for hot paths:
+ * samples are summed into a fixed ring of short time buckets instead
+ * of being appended to growing vectors under a mutex. AddSample() is a
+ * few relaxed atomic loads/stores, FPS() is a lock-free scan of the
+ * ring, and neither ever allocates.
+ *
+ * Exactly ONE thread may call AddSample(); any thread may call FPS().
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > Throughput::Counter counter;
+ * >
+ * > /// Writer thread
+ * > counter.AddSample(bytes_read);
+ * >
+ * > /// Monitor thread: bytes per second over the past 2 seconds
+ * > std::cout << counter.FPS(2.f) << '\n';
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef THROUGHPUT_H__
+#define THROUGHPUT_H__
+
+
+/// System/STL
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+
+namespace Throughput {
+
+  /// Keep every counter on its own cache lines
+  constexpr size_t CACHE_LINE_SIZE = 64;
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Counter class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class alignas(CACHE_LINE_SIZE) Counter {
+
+  public:
+
+    /**
+     * Constructor
+     *
+     * @param bucket_milliseconds Time resolution of the counter
+     * @param bucket_count Ring size; bucket_count*bucket_milliseconds is
+     *                     the longest window FPS() can look at
+     */
+    Counter(unsigned bucket_milliseconds = 10,
+            unsigned bucket_count = 1024);
+
+    /// Destructor
+    ~Counter();
+
+    Counter(const Counter&) = delete;
+    Counter& operator=(const Counter&) = delete;
+
+    /// Add a sample (ONLY from the owning thread)
+    void AddSample(double amount = 1.);
+
+    /**
+     * Estimate the rate over a past time window (same semantics as the
+     * old FPSEstimator::FPS with CountSamples, at bucket resolution)
+     *
+     * @param window_seconds Number of past seconds over which to measure
+     *
+     * @returns Sum of all samples from the past "window_seconds" seconds,
+     *          divided by "window_seconds". If the counter has not yet
+     *          seen samples for that long, a negative value is returned.
+     */
+    double FPS(float window_seconds = 1.f) const;
+
+    /// Reset the instance (ONLY from the owning thread)
+    void Reset();
+
+  private:
+
+    struct Bucket {
+      /// Absolute time slot (Now()/bucket length) the amount belongs to
+      std::atomic<int64_t> slot;
+      std::atomic<double> amount;
+    };
+
+    /// Current absolute time slot
+    int64_t NowSlot() const;
+
+    int64_t m_bucket_nanoseconds;
+    unsigned m_bucket_count;
+    Bucket* m_buckets;
+    /// Time slot of the first sample, or -1
+    std::atomic<int64_t> m_first_slot;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Counter class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /**
+   * Constructor
+   *
+   * @param bucket_milliseconds Time resolution of the counter
+   * @param bucket_count Ring size; bucket_count*bucket_milliseconds is
+   *                     the longest window FPS() can look at
+   */
+  Counter::Counter(unsigned bucket_milliseconds,
+                   unsigned bucket_count)
+    : m_bucket_nanoseconds(bucket_milliseconds * 1000000ll),
+      m_bucket_count(bucket_count)
+  {
+    /// Cache-line aligned (and padded) so that no other data shares the
+    /// written lines
+    const size_t bytes = (bucket_count*sizeof(Bucket) + CACHE_LINE_SIZE - 1)
+                         / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    void* memory = std::aligned_alloc(CACHE_LINE_SIZE, bytes);
+    if (not memory)
+      throw std::bad_alloc();
+    m_buckets = static_cast<Bucket*>(memory);
+    for (unsigned i = 0; i < m_bucket_count; ++i)
+      new (&m_buckets[i]) Bucket;
+    Reset();
+  }
+
+  /// Destructor
+  Counter::~Counter()
+  {
+    for (unsigned i = 0; i < m_bucket_count; ++i)
+      m_buckets[i].~Bucket();
+    std::free(m_buckets);
+  }
+
+  /// Add a sample (ONLY from the owning thread)
+  void Counter::AddSample(double amount)
+  {
+    const int64_t now = NowSlot();
+    Bucket& bucket = m_buckets[now % m_bucket_count];
+
+    if (bucket.slot.load(std::memory_order_relaxed) != now) {
+      /// Recycle an expired bucket; readers which see the invalid slot
+      /// in between skip the bucket
+      bucket.slot.store(-1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      bucket.amount.store(0., std::memory_order_relaxed);
+      bucket.slot.store(now, std::memory_order_release);
+    }
+    bucket.amount.store(bucket.amount.load(std::memory_order_relaxed) + amount,
+                        std::memory_order_relaxed);
+
+    if (m_first_slot.load(std::memory_order_relaxed) < 0)
+      m_first_slot.store(now, std::memory_order_relaxed);
+  }
+
+  /**
+   * Estimate the rate over a past time window (same semantics as the
+   * old FPSEstimator::FPS with CountSamples, at bucket resolution)
+   *
+   * @param window_seconds Number of past seconds over which to measure
+   *
+   * @returns Sum of all samples from the past "window_seconds" seconds,
+   *          divided by "window_seconds". If the counter has not yet
+   *          seen samples for that long, a negative value is returned.
+   */
+  double Counter::FPS(float window_seconds) const
+  {
+    const int64_t now = NowSlot();
+    int64_t window_slots = static_cast<int64_t>(window_seconds * 1e9 /
+                                                m_bucket_nanoseconds + 0.5);
+    if (window_slots < 1)
+      window_slots = 1;
+    if (window_slots > m_bucket_count)
+      window_slots = m_bucket_count;
+
+    const int64_t first = m_first_slot.load(std::memory_order_relaxed);
+    if (first < 0 or now - first < window_slots)
+      return -1.;
+
+    double samples = 0.;
+    for (int64_t slot = now - window_slots + 1; slot <= now; ++slot) {
+      const Bucket& bucket = m_buckets[slot % m_bucket_count];
+      if (bucket.slot.load(std::memory_order_acquire) != slot)
+        continue;
+      const double amount = bucket.amount.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      /// Only count the amount if the bucket was not recycled meanwhile
+      if (bucket.slot.load(std::memory_order_relaxed) == slot)
+        samples += amount;
+    }
+
+    return samples / (window_slots * m_bucket_nanoseconds / 1e9);
+  }
+
+  /// Reset the instance (ONLY from the owning thread)
+  void Counter::Reset()
+  {
+    for (unsigned i = 0; i < m_bucket_count; ++i) {
+      m_buckets[i].slot.store(-1, std::memory_order_relaxed);
+      m_buckets[i].amount.store(0., std::memory_order_relaxed);
+    }
+    m_first_slot.store(-1, std::memory_order_relaxed);
+  }
+
+  /// Current absolute time slot
+  int64_t Counter::NowSlot() const
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count()
+           / m_bucket_nanoseconds;
+  }
+
+
+}  // namespace Throughput
+
+
+#endif  // THROUGHPUT_H__
+
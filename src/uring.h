@@ -0,0 +1,401 @@
+/**
+ * ====================================================================
+ * Author: Nikolaus Mayer, 2019 (mayern@cs.uni-freiburg.de)
+ * ====================================================================
+ * Minimal io_uring wrapper on top of the raw syscalls (header-only)
+ *
+ * This does not need liburing; it only uses <linux/io_uring.h> and
+ * thus works on every Linux >= 5.6 (IORING_OP_READ) with matching
+ * kernel headers.
+ * Fixed buffers and fixed files are optional: if the kernel refuses to
+ * register them, the ring still works with plain buffers/descriptors.
+ * ====================================================================
+ *
+ * Usage Example:
+ *
+ * >
+ * > URing::Ring ring;
+ * > if (not ring.Init(8))
+ * >   return;
+ * >
+ * > io_uring_sqe* sqe{ring.GetSQE()};
+ * > URing::PrepareRead(sqe, fd, buffer, length, offset);
+ * > sqe->user_data = 42;
+ * > ring.Submit(1);
+ * >
+ * > io_uring_cqe cqe;
+ * > while (ring.PopCQE(cqe)) {
+ * >   /// cqe.user_data == 42, cqe.res == bytes read (or -errno)
+ * > }
+ * >
+ *
+ * ====================================================================
+ */
+
+
+#ifndef URING_H__
+#define URING_H__
+
+
+/// System/STL
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+
+namespace URing {
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Non-class functions
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Prepare a plain read into an arbitrary buffer
+  static void PrepareRead(io_uring_sqe* sqe,
+                          int fd,
+                          void* buffer,
+                          unsigned length,
+                          unsigned long long offset)
+  {
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd     = fd;
+    sqe->off    = offset;
+    sqe->addr   = reinterpret_cast<unsigned long long>(buffer);
+    sqe->len    = length;
+  }
+
+  /// Prepare a read into a registered (fixed) buffer
+  static void PrepareReadFixed(io_uring_sqe* sqe,
+                               int fd,
+                               void* buffer,
+                               unsigned length,
+                               unsigned long long offset,
+                               unsigned short buffer_index)
+  {
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode    = IORING_OP_READ_FIXED;
+    sqe->fd        = fd;
+    sqe->off       = offset;
+    sqe->addr      = reinterpret_cast<unsigned long long>(buffer);
+    sqe->len       = length;
+    sqe->buf_index = buffer_index;
+  }
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Ring class declaration
+  /// /////////////////////////////////////////////////////////////////
+  class Ring {
+
+  public:
+
+    /// Constructor
+    Ring();
+
+    /// Destructor (unmaps the rings and closes the ring descriptor)
+    ~Ring();
+
+    Ring(const Ring&) = delete;
+    Ring& operator=(const Ring&) = delete;
+
+    /**
+     * Set up the ring
+     *
+     * @param entries Submission queue size (rounded up by the kernel)
+     *
+     * @returns TRUE IFF the ring is usable, ELSE FALSE (errno is kept)
+     */
+    bool Init(unsigned entries);
+
+    /// Register buffers for IORING_OP_READ_FIXED
+    bool RegisterBuffers(const std::vector<iovec>& buffers);
+
+    /// Register a fixed-file table; -1 entries are empty slots
+    bool RegisterFiles(const std::vector<int>& fds);
+
+    /// Put "fd" into fixed-file slot "slot" (-1 clears the slot)
+    bool UpdateFile(unsigned slot, int fd);
+
+    /// Get a free submission queue entry, or NULLPTR if the SQ is full
+    io_uring_sqe* GetSQE();
+
+    /**
+     * Submit all queued entries to the kernel
+     *
+     * @param wait_for Block until at least this many completions exist
+     *
+     * @returns Number of submitted entries, or -errno
+     */
+    int Submit(unsigned wait_for = 0);
+
+    /**
+     * Submit all queued entries and wait for completions, but at most
+     * "timeout_nanoseconds" long. Kernels without IORING_FEAT_EXT_ARG
+     * (< 5.11) ignore the timeout and wait for the completions.
+     *
+     * @param wait_for Block until at least this many completions exist
+     * @param timeout_nanoseconds Give up waiting after this time
+     *
+     * @returns Number of submitted entries, or -errno (a timeout is not
+     *          an error)
+     */
+    int SubmitAndWait(unsigned wait_for, long long timeout_nanoseconds);
+
+    /// Pop one completion; returns FALSE IFF the CQ is empty
+    bool PopCQE(io_uring_cqe& cqe);
+
+  private:
+
+    int m_ring_fd;
+    unsigned m_entries;
+    unsigned m_features;
+    unsigned m_unsubmitted;
+
+    void* m_sq_ring_ptr;
+    void* m_cq_ring_ptr;
+    size_t m_sq_ring_size;
+    size_t m_cq_ring_size;
+
+    unsigned* m_sq_head;
+    unsigned* m_sq_tail;
+    unsigned* m_sq_mask;
+    unsigned* m_sq_array;
+    io_uring_sqe* m_sqes;
+    size_t m_sqes_size;
+
+    unsigned* m_cq_head;
+    unsigned* m_cq_tail;
+    unsigned* m_cq_mask;
+    io_uring_cqe* m_cqes;
+  };
+
+
+
+  /// /////////////////////////////////////////////////////////////////
+  /// Ring class implementation
+  /// /////////////////////////////////////////////////////////////////
+
+  /// Constructor
+  Ring::Ring()
+    : m_ring_fd(-1),
+      m_entries(0),
+      m_features(0),
+      m_unsubmitted(0),
+      m_sq_ring_ptr(MAP_FAILED),
+      m_cq_ring_ptr(MAP_FAILED),
+      m_sq_ring_size(0),
+      m_cq_ring_size(0),
+      m_sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+      m_sqes_size(0)
+  { }
+
+  /// Destructor
+  Ring::~Ring()
+  {
+    if (m_sqes != MAP_FAILED)
+      munmap(m_sqes, m_sqes_size);
+    if (m_cq_ring_ptr != MAP_FAILED and m_cq_ring_ptr != m_sq_ring_ptr)
+      munmap(m_cq_ring_ptr, m_cq_ring_size);
+    if (m_sq_ring_ptr != MAP_FAILED)
+      munmap(m_sq_ring_ptr, m_sq_ring_size);
+    if (m_ring_fd >= 0)
+      close(m_ring_fd);
+  }
+
+  /**
+   * Set up the ring
+   *
+   * @param entries Submission queue size (rounded up by the kernel)
+   *
+   * @returns TRUE IFF the ring is usable, ELSE FALSE (errno is kept)
+   */
+  bool Ring::Init(unsigned entries)
+  {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+
+    m_ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (m_ring_fd < 0)
+      return false;
+    m_entries = params.sq_entries;
+    m_features = params.features;
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes +
+                     params.cq_entries*sizeof(io_uring_cqe);
+    /// Since Linux 5.4 both rings live in one mapping
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      m_sq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+      m_cq_ring_size = m_sq_ring_size;
+    }
+
+    m_sq_ring_ptr = mmap(nullptr, m_sq_ring_size, PROT_READ|PROT_WRITE,
+                         MAP_SHARED|MAP_POPULATE, m_ring_fd,
+                         IORING_OFF_SQ_RING);
+    if (m_sq_ring_ptr == MAP_FAILED)
+      return false;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+      m_cq_ring_ptr = m_sq_ring_ptr;
+    } else {
+      m_cq_ring_ptr = mmap(nullptr, m_cq_ring_size, PROT_READ|PROT_WRITE,
+                           MAP_SHARED|MAP_POPULATE, m_ring_fd,
+                           IORING_OFF_CQ_RING);
+      if (m_cq_ring_ptr == MAP_FAILED)
+        return false;
+    }
+
+    m_sqes_size = params.sq_entries*sizeof(io_uring_sqe);
+    m_sqes = static_cast<io_uring_sqe*>(
+               mmap(nullptr, m_sqes_size, PROT_READ|PROT_WRITE,
+                    MAP_SHARED|MAP_POPULATE, m_ring_fd, IORING_OFF_SQES));
+    if (m_sqes == MAP_FAILED)
+      return false;
+
+    char* sq{static_cast<char*>(m_sq_ring_ptr)};
+    m_sq_head  = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    m_sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    m_sq_mask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+    char* cq{static_cast<char*>(m_cq_ring_ptr)};
+    m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    m_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    m_cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    return true;
+  }
+
+  /// Register buffers for IORING_OP_READ_FIXED
+  bool Ring::RegisterBuffers(const std::vector<iovec>& buffers)
+  {
+    return syscall(__NR_io_uring_register, m_ring_fd,
+                   IORING_REGISTER_BUFFERS,
+                   buffers.data(), buffers.size()) == 0;
+  }
+
+  /// Register a fixed-file table; -1 entries are empty slots
+  bool Ring::RegisterFiles(const std::vector<int>& fds)
+  {
+    return syscall(__NR_io_uring_register, m_ring_fd,
+                   IORING_REGISTER_FILES,
+                   fds.data(), fds.size()) == 0;
+  }
+
+  /// Put "fd" into fixed-file slot "slot" (-1 clears the slot)
+  bool Ring::UpdateFile(unsigned slot, int fd)
+  {
+    io_uring_files_update update;
+    std::memset(&update, 0, sizeof(update));
+    update.offset = slot;
+    update.fds    = reinterpret_cast<unsigned long long>(&fd);
+    return syscall(__NR_io_uring_register, m_ring_fd,
+                   IORING_REGISTER_FILES_UPDATE,
+                   &update, 1) == 1;
+  }
+
+  /// Get a free submission queue entry, or NULLPTR if the SQ is full
+  io_uring_sqe* Ring::GetSQE()
+  {
+    /// Only we write the SQ tail, but the kernel moves the head
+    const unsigned tail{*m_sq_tail};
+    const unsigned head{__atomic_load_n(m_sq_head, __ATOMIC_ACQUIRE)};
+    if (tail - head >= m_entries)
+      return nullptr;
+
+    const unsigned index{tail & *m_sq_mask};
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail+1, __ATOMIC_RELEASE);
+    ++m_unsubmitted;
+    return &m_sqes[index];
+  }
+
+  /**
+   * Submit all queued entries to the kernel
+   *
+   * @param wait_for Block until at least this many completions exist
+   *
+   * @returns Number of submitted entries, or -errno
+   */
+  int Ring::Submit(unsigned wait_for)
+  {
+    int result;
+    do {
+      result = syscall(__NR_io_uring_enter, m_ring_fd, m_unsubmitted,
+                       wait_for, (wait_for > 0 ? IORING_ENTER_GETEVENTS : 0),
+                       nullptr, 0);
+    } while (result < 0 and errno == EINTR);
+
+    if (result < 0)
+      return -errno;
+    m_unsubmitted -= result;
+    return result;
+  }
+
+  /**
+   * Submit all queued entries and wait for completions, but at most
+   * "timeout_nanoseconds" long. Kernels without IORING_FEAT_EXT_ARG
+   * (< 5.11) ignore the timeout and wait for the completions.
+   *
+   * @param wait_for Block until at least this many completions exist
+   * @param timeout_nanoseconds Give up waiting after this time
+   *
+   * @returns Number of submitted entries, or -errno (a timeout is not
+   *          an error)
+   */
+  int Ring::SubmitAndWait(unsigned wait_for, long long timeout_nanoseconds)
+  {
+    if (not (m_features & IORING_FEAT_EXT_ARG))
+      return Submit(wait_for);
+
+    __kernel_timespec timeout;
+    timeout.tv_sec  = timeout_nanoseconds / 1000000000ll;
+    timeout.tv_nsec = timeout_nanoseconds % 1000000000ll;
+    io_uring_getevents_arg arg;
+    std::memset(&arg, 0, sizeof(arg));
+    arg.ts = reinterpret_cast<unsigned long long>(&timeout);
+
+    int result;
+    do {
+      result = syscall(__NR_io_uring_enter, m_ring_fd, m_unsubmitted,
+                       wait_for,
+                       IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                       &arg, sizeof(arg));
+    } while (result < 0 and errno == EINTR);
+
+    if (result < 0)
+      return (errno == ETIME ? 0 : -errno);
+    m_unsubmitted -= result;
+    return result;
+  }
+
+  /// Pop one completion; returns FALSE IFF the CQ is empty
+  bool Ring::PopCQE(io_uring_cqe& cqe)
+  {
+    /// Only we write the CQ head, but the kernel moves the tail
+    const unsigned head{*m_cq_head};
+    const unsigned tail{__atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE)};
+    if (head == tail)
+      return false;
+
+    cqe = m_cqes[head & *m_cq_mask];
+    __atomic_store_n(m_cq_head, head+1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+
+}  // namespace URing
+
+
+#endif  // URING_H__
+